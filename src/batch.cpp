@@ -0,0 +1,291 @@
+module;
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+export module flit.batch;
+
+import flit.game;
+import flit.positions;
+import flit.evaluator;
+import flit.huge_pages;
+
+namespace flit
+{
+
+export enum class OutputFormat {
+	Csv,
+	JsonLines,
+};
+
+export struct AnalyzeOptions
+{
+	std::string input;
+	/// Results are written to standard output when empty
+	std::string output;
+	OutputFormat format = OutputFormat::Csv;
+	int depth = 1;
+	unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+	/// Transposition table entries per worker thread, or of the shared table
+	std::size_t transposition_table_size = 1 << 22;
+	/// Name of a shared memory segment holding one transposition table for all threads and processes, if not empty
+	std::string shared_transposition_table;
+	/// File of a network evaluating positions in place of the heuristic, if not empty
+	std::string network;
+	SearchOptions search;
+};
+
+namespace
+{
+
+template <typename T>
+class BoundedQueue
+{
+  public:
+	explicit BoundedQueue(std::size_t capacity) : _capacity{capacity} {}
+
+	/// Blocks until there is room for the item, or drops it and returns false once the queue is closed
+	bool push(T value)
+	{
+		std::unique_lock lock{_mutex};
+		_not_full.wait(lock, [&] { return _items.size() < _capacity or _closed; });
+		if (_closed)
+		{
+			return false;
+		}
+		_items.push_back(std::move(value));
+		_not_empty.notify_one();
+		return true;
+	}
+
+	/// Blocks until an item is available, or returns nothing once the queue is closed and drained
+	std::optional<T> pop()
+	{
+		std::unique_lock lock{_mutex};
+		_not_empty.wait(lock, [&] { return not _items.empty() or _closed; });
+		if (_items.empty())
+		{
+			return std::nullopt;
+		}
+		T value = std::move(_items.front());
+		_items.pop_front();
+		_not_full.notify_one();
+		return value;
+	}
+
+	void close()
+	{
+		{
+			std::lock_guard lock{_mutex};
+			_closed = true;
+		}
+		_not_empty.notify_all();
+		_not_full.notify_all();
+	}
+
+  private:
+	std::size_t _capacity;
+	std::deque<T> _items;
+	bool _closed = false;
+	std::mutex _mutex;
+	std::condition_variable _not_full;
+	std::condition_variable _not_empty;
+};
+
+struct Job
+{
+	std::size_t index;
+	GameState state;
+};
+
+void
+write_result(
+	std::ostream &out,
+	OutputFormat format,
+	std::size_t index,
+	std::optional<solve_result> best,
+	SearchStats const &stats,
+	std::chrono::milliseconds time)
+{
+	std::string move = best ? std::format("{}", best->move) : std::string{};
+	int score = best ? best->score : 0;
+	switch (format)
+	{
+	case OutputFormat::Csv:
+		std::println(
+			out,
+			"{},{},{},{},{},{},{},{},{},{}",
+			index,
+			move,
+			score,
+			stats.nodes,
+			stats.leaf_nodes,
+			stats.transposition_table_hits,
+			stats.reductions,
+			stats.reduction_re_searches,
+			stats.futility_prunes,
+			time.count());
+		break;
+	case OutputFormat::JsonLines:
+		std::println(
+			out,
+			R"({{"index":{},"move":"{}","score":{},"nodes":{},"leaf_nodes":{},"tt_hits":{},"reductions":{},"re_searches":{},"futility_prunes":{},"time_ms":{}}})",
+			index,
+			move,
+			score,
+			stats.nodes,
+			stats.leaf_nodes,
+			stats.transposition_table_hits,
+			stats.reductions,
+			stats.reduction_re_searches,
+			stats.futility_prunes,
+			time.count());
+		break;
+	}
+}
+
+} // namespace
+
+/// Evaluates every position of a position file, writing one result per position.
+/// Results are written in completion order; the index column identifies the position.
+export void
+analyze(AnalyzeOptions const &options)
+{
+	std::ifstream in{options.input, std::ios::binary};
+	if (not in)
+	{
+		throw std::runtime_error{"Could not open input file"};
+	}
+	PositionReader reader{in};
+
+	std::ofstream file;
+	if (not options.output.empty())
+	{
+		file.open(options.output);
+		if (not file)
+		{
+			throw std::runtime_error{"Could not open output file"};
+		}
+	}
+	std::ostream &out = options.output.empty() ? std::cout : file;
+	if (options.format == OutputFormat::Csv)
+	{
+		std::println(out, "index,move,score,nodes,leaf_nodes,tt_hits,reductions,re_searches,futility_prunes,time_ms");
+	}
+
+	// Mapped once and read by every worker
+	std::shared_ptr<Network const> network;
+	if (not options.network.empty())
+	{
+		network = std::make_shared<Network const>(Network::open(options.network));
+	}
+
+	// Opened and checked once here, so that a bad segment is reported before any work starts
+	std::optional<TranspositionTable> shared_table;
+	if (not options.shared_transposition_table.empty())
+	{
+		shared_table = TranspositionTable::shared(
+			options.shared_transposition_table,
+			options.transposition_table_size,
+			Solver::evaluator_identity(network.get()));
+	}
+	std::vector<std::unique_ptr<Solver>> solvers;
+	for (unsigned i = 0; i < options.threads; ++i)
+	{
+		solvers.push_back(std::make_unique<Solver>(
+			GameState{},
+			shared_table ? shared_table->share() : TranspositionTable{options.transposition_table_size},
+			options.search));
+		solvers.back()->network(network);
+	}
+
+	std::println(stderr, "Transposition tables on {}", page_kind_name(solvers.front()->transposition_table_pages()));
+
+	BoundedQueue<Job> queue{4uz * options.threads};
+	std::mutex out_mutex;
+	// The first error of a worker, which stops the others and is rethrown once they are joined
+	std::exception_ptr error;
+	{
+		std::vector<std::jthread> workers;
+		for (auto &solver : solvers)
+		{
+			workers.emplace_back(
+				[&]
+				{
+					try
+					{
+						while (auto job = queue.pop())
+						{
+							auto begin = std::chrono::steady_clock::now();
+							solver->reset(job->state);
+							auto evaluations = solver->solve(job->state.turn(), options.depth);
+							auto end = std::chrono::steady_clock::now();
+
+							std::optional<solve_result> best;
+							if (not evaluations.empty())
+							{
+								best = evaluations[0];
+							}
+							std::lock_guard lock{out_mutex};
+							write_result(
+								out,
+								options.format,
+								job->index,
+								best,
+								solver->stats(),
+								std::chrono::duration_cast<std::chrono::milliseconds>(end - begin));
+						}
+					}
+					catch (...)
+					{
+						std::lock_guard lock{out_mutex};
+						if (not error)
+						{
+							error = std::current_exception();
+						}
+						queue.close();
+					}
+				});
+		}
+
+		std::size_t index = 0;
+		try
+		{
+			while (auto record = reader.read())
+			{
+				if (not queue.push({index++, std::move(record->state)}))
+				{
+					break;
+				}
+			}
+		}
+		catch (...)
+		{
+			queue.close();
+			throw;
+		}
+		queue.close();
+	}
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+} // namespace flit
\ No newline at end of file
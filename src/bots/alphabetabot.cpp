@@ -1,5 +1,6 @@
 module;
 
+#include <cstddef>
 #include <utility>
 
 export module flit.bots.alphabetabot;
@@ -10,17 +11,28 @@ import flit.evaluator;
 namespace flit::bots
 {
 
+export struct AlphaBetaOptions
+{
+	int depth = 1;
+	/// Size of the transposition table
+	std::size_t hash_megabytes = 64;
+};
+
 export class AlphaBetaBot : public Bot
 {
   public:
+	AlphaBetaBot(AlphaBetaOptions options = {}) : _options{options} {}
+
 	Move choose_move(GameState game) override
 	{
-		Solver solver{std::move(game)};
-		auto evaluations = solver.solve(game.turn(), 1);
+		Cell player = game.turn();
+		Solver solver{std::move(game), Solver::transposition_table_entries(_options.hash_megabytes)};
+		auto evaluations = solver.solve(player, _options.depth);
 		return evaluations[0].move;
 	}
 
   private:
+	AlphaBetaOptions _options;
 };
 
 } // namespace flit::bots
\ No newline at end of file
@@ -10,12 +10,14 @@ export module flit.bots;
 export import flit.bots.base;
 import flit.bots.randombot;
 import flit.bots.alphabetabot;
+import flit.bots.mctsbot;
 
 namespace flit::bots
 {
 export std::map<std::string, std::function<std::unique_ptr<Bot>()>> const bots{
 	{"Random Bot", [] { return std::make_unique<RandomBot>(); }},
 	{"Alpha-Beta Bot", [] { return std::make_unique<AlphaBetaBot>(); }},
+	{"MCTS Bot", [] { return std::make_unique<MctsBot>(); }},
 };
 
 } // namespace flit::bots
\ No newline at end of file
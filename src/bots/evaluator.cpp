@@ -3,82 +3,437 @@ module;
 #include <libassert/assert.hpp>
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <generator>
 #include <limits>
 #include <memory>
-#include <print>
+#include <optional>
 #include <random>
 #include <ranges>
+#include <stop_token>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 export module flit.evaluator;
 
 export import flit.game;
+import flit.huge_pages;
+export import flit.network;
+export import flit.transposition_table;
 
 namespace flit
 {
 
-export struct solve_result
+export template <std::uint_fast8_t Rows, std::uint_fast8_t Cols>
+struct basic_solve_result
 {
-	Move move;
+	BasicMove<Rows, Cols> move;
 	int score;
 };
 
-export class Solver
+export struct SearchStats
+{
+	std::size_t nodes = 0;
+	std::size_t leaf_nodes = 0;
+	std::size_t transposition_table_hits = 0;
+	/// Moves searched to a reduced depth first
+	std::size_t reductions = 0;
+	/// Reduced searches that failed high and had to be verified at full depth
+	std::size_t reduction_re_searches = 0;
+	/// Quiet moves skipped at frontier nodes
+	std::size_t futility_prunes = 0;
+	/// Nodes searched past the horizon to resolve captures
+	std::size_t quiescence_nodes = 0;
+	/// Positions found repeating one earlier on the search line
+	std::size_t repetitions = 0;
+	/// Static evaluations asked for, and those found in the evaluation cache
+	std::size_t evaluations = 0;
+	std::size_t evaluation_cache_hits = 0;
+	/// Spawns out of reach of every piece evaluated as one
+	std::size_t collapsed_spawns = 0;
+	/// Nodes cut off by a child's transposition table entry before searching any move
+	std::size_t enhanced_cutoffs = 0;
+};
+
+/// Search extensions and selective search switches, the latter trading exactness for depth
+export struct SearchOptions
+{
+	/// Keep searching blue captures at the horizon instead of evaluating positions mid-exchange
+	bool quiescence = true;
+	/// Search quiet moves late in the move order to a reduced depth first
+	bool late_move_reductions = false;
+	/// Moves searched at full depth before reductions apply
+	int reduction_move_count = 3;
+	/// Remaining depth from which moves are reduced, high enough that reduced searches still see the reply
+	int reduction_min_depth = 3;
+	/// Skip quiet moves at frontier nodes whose static evaluation is far below alpha
+	bool futility_pruning = false;
+	/// How far a quiet move may at most raise the static evaluation
+	int futility_margin = 500;
+	/// When positive, only this many sources per target are searched, those losing the least cover
+	int max_sources = 0;
+	/// Root moves whose scores are proven exact; the scores of the others are only upper bounds
+	int multipv = 1;
+	/// Score of a position repeating one earlier on the search line, for the player to move. Play could go on
+	/// forever from there, which wins neither player the game.
+	int repetition_score = 0;
+};
+
+/// Sets a search option by its name in the repl and engine, e.g. `lmr` or `futility-margin`.
+/// Returns false if there is no option of that name.
+export bool
+set_search_option(SearchOptions &options, std::string_view name, int value)
+{
+	if (name == "quiescence")
+	{
+		options.quiescence = value != 0;
+	}
+	else if (name == "lmr")
+	{
+		options.late_move_reductions = value != 0;
+	}
+	else if (name == "lmr-moves")
+	{
+		options.reduction_move_count = value;
+	}
+	else if (name == "lmr-depth")
+	{
+		options.reduction_min_depth = value;
+	}
+	else if (name == "futility")
+	{
+		options.futility_pruning = value != 0;
+	}
+	else if (name == "futility-margin")
+	{
+		options.futility_margin = value;
+	}
+	else if (name == "max-sources")
+	{
+		options.max_sources = value;
+	}
+	else if (name == "multipv")
+	{
+		options.multipv = std::max(1, value);
+	}
+	else if (name == "repetition-score")
+	{
+		options.repetition_score = value;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+namespace
+{
+
+constexpr int score_infinity = 100000;
+/// Half-width of the first aspiration window around the previous iteration's score
+constexpr int aspiration_window = 500;
+/// Nodes searched between checks for a stop request
+constexpr std::size_t stop_check_interval = 1024;
+/// Search line index of a subtree without repetitions
+constexpr std::size_t no_repetition = std::numeric_limits<std::size_t>::max();
+/// Entries of the evaluation cache, filling one huge page
+constexpr std::size_t evaluation_cache_size = 1 << 18;
+/// Quotients rounded down and up, for dividing window bounds by a chance node child's weight
+constexpr std::int64_t
+floor_div(std::int64_t numerator, std::int64_t denominator)
+{
+	return numerator / denominator - (numerator % denominator < 0);
+}
+
+constexpr std::int64_t
+ceil_div(std::int64_t numerator, std::int64_t denominator)
+{
+	return numerator / denominator + (numerator % denominator > 0);
+}
+
+/// Remaining depth from which the children's entries are probed for a cutoff before any move is searched
+constexpr int enhanced_cutoff_min_depth = 2;
+/// Children whose transposition table entries are probed for an enhanced transposition cutoff
+constexpr int enhanced_cutoff_moves = 8;
+
+} // namespace
+
+export template <std::uint_fast8_t Rows, std::uint_fast8_t Cols>
+class BasicSolver
 {
   public:
-	Solver(GameState state, std::size_t transposition_table_size = 1 << 25)
-		: state{std::move(state)}, _transposition_table_size{transposition_table_size},
-		  _transposition_table{std::make_unique<TranspositionTableEntry[]>(_transposition_table_size)}
+	using State = BasicGameState<Rows, Cols>;
+	using Move = State::Move;
+	using solve_result = basic_solve_result<Rows, Cols>;
+	using Network = BasicNetwork<Rows, Cols>;
+
+	BasicSolver(State state, std::size_t transposition_table_size = 1 << 25, SearchOptions options = {})
+		: BasicSolver{std::move(state), TranspositionTable{transposition_table_size}, options}
+	{
+	}
+
+	/// A solver using the given table, which may be shared with other solvers and processes
+	BasicSolver(State state, TranspositionTable transposition_table, SearchOptions options = {})
+		: state{std::move(state)}, _options{options}, _transposition_table{std::move(transposition_table)},
+		  _evaluation_cache{evaluation_cache_size}
+	{
+	}
+
+	/// The number of transposition table entries that fit in the given number of megabytes
+	static constexpr std::size_t transposition_table_entries(std::size_t megabytes)
+	{
+		return TranspositionTable::entries(megabytes);
+	}
+
+	/// Replaces the position to be solved, keeping the transposition table and evaluation cache warm
+	void reset(State new_state)
+	{
+		state = std::move(new_state);
+		_stats = {};
+	}
+
+	/// Replaces the search options, keeping the transposition table warm
+	void options(SearchOptions options) { _options = options; }
+
+	/// Evaluates positions with the network instead of the heuristic, or with the heuristic again when null.
+	/// Evaluations cached and scores stored with the other are dropped, unless the table is shared, in which case it
+	/// must have been opened with the network's identity.
+	void network(std::shared_ptr<Network const> network)
+	{
+		_network = std::move(network);
+		_evaluation_cache = EvaluationCache{evaluation_cache_size};
+		_transposition_table.clear();
+	}
+
+	/// Identifies the static evaluation of a solver using the network, or the heuristic when null, for opening a
+	/// shared transposition table
+	static std::uint64_t evaluator_identity(Network const *network)
 	{
+		// Zero marks a shared table nobody has claimed yet
+		return (network ? network->identity() : evaluation_weights_hash) | 1;
 	}
 
-	std::vector<solve_result> solve(Cell player, int depth)
+	/// Searches every root move with iterative deepening up to `depth`, best first.
+	/// The first `multipv` results hold exact scores; the scores of the others are upper bounds.
+	/// Once `stop` is requested the search returns the results of the deepest completed iteration, which is at least
+	/// the first. `on_iteration` is called with the results of every completed iteration.
+	std::vector<solve_result> solve(
+		Cell player,
+		int depth,
+		std::stop_token stop = {},
+		std::function<void(int depth, std::vector<solve_result> const &results)> const &on_iteration = {})
 	{
 		std::vector<solve_result> evaluations;
 		state.turn(player);
 		for (Move move : state.get_legal_moves())
 		{
-			state.commit(move);
-			evaluations.emplace_back(move, -evaluate(true, depth, -100000, 100000));
-			state.uncommit(move);
+			evaluations.push_back({move, 0});
+		}
+
+		_stop = {};
+		_aborted = false;
+		_path = {state.hash()};
+		if (_network)
+		{
+			_accumulators = {_network->refresh(state)};
+		}
+		_repetition_index = no_repetition;
+		std::vector<solve_result> completed;
+		int previous_score = 0;
+		for (int iteration = 0; iteration <= depth and not evaluations.empty(); ++iteration)
+		{
+			if (iteration == 1)
+			{
+				_stop = stop;
+			}
+			completed = evaluations;
+			// The exact scores of the moves after the best may lie anywhere below it
+			int delta = _options.multipv > 1 ? 2 * score_infinity : aspiration_window;
+			int alpha = iteration == 0 ? -score_infinity : std::max(previous_score - delta, -score_infinity);
+			int beta = iteration == 0 ? score_infinity : std::min(previous_score + delta, score_infinity);
+			while (true)
+			{
+				int score = search_root(evaluations, iteration, alpha, beta);
+				if (_aborted)
+				{
+					break;
+				}
+				else if (score <= alpha and alpha > -score_infinity)
+				{
+					delta *= 4;
+					alpha = std::max(previous_score - delta, -score_infinity);
+				}
+				else if (score >= beta and beta < score_infinity)
+				{
+					delta *= 4;
+					beta = std::min(previous_score + delta, score_infinity);
+				}
+				else
+				{
+					previous_score = score;
+					break;
+				}
+			}
+			if (_aborted)
+			{
+				return completed;
+			}
+			std::ranges::stable_sort(evaluations, [](auto const &a, auto const &b) { return a.score > b.score; });
+			if (on_iteration)
+			{
+				on_iteration(iteration, evaluations);
+			}
 		}
-		std::ranges::sort(evaluations, [](auto const &a, auto const &b) { return a.score > b.score; });
-		std::println("Evaluated nodes: {} ({} leaves)", _nodes, _leaf_nodes);
-		std::println(
-			"Transposition table hits: {} ({:.2f}%)",
-			_transposition_table_hits,
-			100.0 * static_cast<double>(_transposition_table_hits) / static_cast<double>(_nodes));
 		return evaluations;
 	}
 
+	/// The line starting with a root move of the last search, following the best moves stored in the transposition
+	/// table for at most `max_length` moves. Blue spawns are assumed not to happen along the line.
+	std::vector<Move> principal_variation(Move move, std::size_t max_length)
+	{
+		std::vector<Move> line{move};
+		state.commit(move);
+		while (line.size() < max_length and state.winner() == Cell::Empty)
+		{
+			auto entry = _transposition_table.probe(state.hash());
+			if (not entry or entry->best_from == entry->best_to)
+			{
+				break;
+			}
+			// Also guards against hash collisions
+			auto moves = state.moves();
+			auto next = std::ranges::find_if(
+				moves,
+				[&](Move candidate) { return candidate.from == entry->best_from and candidate.to == entry->best_to; });
+			if (next == moves.end())
+			{
+				break;
+			}
+			line.push_back(*next);
+			state.commit(line.back());
+		}
+		for (Move played : line | std::views::reverse)
+		{
+			state.uncommit(played);
+		}
+		return line;
+	}
+
+	SearchStats const &stats() const { return _stats; }
+
+	PageKind transposition_table_pages() const { return _transposition_table.page_kind(); }
+
   private:
+	/// A child of a chance node, the weight of its score, and the bounds on its score found so far
+	struct ChanceChild
+	{
+		std::optional<typename State::Index> spawn;
+		std::int64_t weight = 0;
+		int lower = -score_infinity;
+		int upper = score_infinity;
+	};
+
+	/// Principal variation search over the root moves, best-first from the previous iteration. The first `multipv`
+	/// moves get a full window; every later move only needs an exact score if it beats the worst of the best so far.
+	int search_root(std::vector<solve_result> &evaluations, int depth, int alpha, int beta)
+	{
+		std::size_t const multipv = _options.multipv;
+		// Exact scores of the best moves so far, from best to worst
+		std::vector<int> best_scores;
+		for (auto [i, evaluation] : evaluations | std::views::enumerate)
+		{
+			int const bound = best_scores.size() < multipv ? alpha : std::max(alpha, best_scores.back());
+			commit(evaluation.move);
+			int score = static_cast<std::size_t>(i) < multipv ? -evaluate(true, depth, -beta, -alpha)
+															  : search_null_window(depth, 0, bound, beta);
+			uncommit(evaluation.move);
+
+			evaluation.score = score;
+			if (score > bound)
+			{
+				best_scores.insert(std::ranges::upper_bound(best_scores, score, std::greater{}), score);
+				if (best_scores.size() > multipv)
+				{
+					best_scores.pop_back();
+				}
+			}
+			if (score >= beta or _aborted)
+			{
+				return score;
+			}
+		}
+		return best_scores.empty() ? alpha : best_scores.front();
+	}
+
+	/// Proves the current child no better than alpha, re-searching with the full window if it is.
+	/// A reduced search that fails high is first verified with a null window at full depth.
+	int search_null_window(int depth, int reduction, int alpha, int beta)
+	{
+		int score = -evaluate(true, depth - reduction, -alpha - 1, -alpha);
+		if (reduction > 0)
+		{
+			++_stats.reductions;
+			if (score > alpha)
+			{
+				++_stats.reduction_re_searches;
+				score = -evaluate(true, depth, -alpha - 1, -alpha);
+			}
+		}
+		if (score > alpha and score < beta)
+		{
+			score = -evaluate(true, depth, -beta, -alpha);
+		}
+		return score;
+	}
+
+	/// Scores a position from the perspective of the player to move. Returns a meaningless score, and stores
+	/// nothing, once the search is aborted.
 	int evaluate(bool blue, int depth, int alpha, int beta)
 	{
-		++_nodes;
+		if (_stats.nodes % stop_check_interval == 0 and _stop.stop_requested())
+		{
+			_aborted = true;
+		}
+		if (_aborted)
+		{
+			return 0;
+		}
+		++_stats.nodes;
 		int const original_alpha = alpha;
 		int const original_beta = beta;
 		auto hash = state.hash();
-		auto &entry = get_transposition_entry(hash);
-		if (not blue and entry.is_valid and entry.depth >= depth)
+		// Pieces shuffling back and forth without a capture or spawn in between repeat positions
+		if (auto repeated = blue ? _path.end() : std::ranges::find(_path, hash); repeated != _path.end())
+		{
+			++_stats.repetitions;
+			_repetition_index = std::min<std::size_t>(_repetition_index, repeated - _path.begin());
+			return _options.repetition_score;
+		}
+		// A chance node has the same position as its child without a spawn, so it gets an entry of its own
+		auto const key = blue ? hash ^ chance_node_key : hash;
+		if (auto entry = _transposition_table.probe(key); entry and entry->depth >= depth)
 		{
-			++_transposition_table_hits;
-			switch (entry.bound)
+			++_stats.transposition_table_hits;
+			switch (entry->bound)
 			{
-			case TranspositionBound::Exact: return entry.score;
+			case TranspositionBound::Exact: return entry->score;
 			case TranspositionBound::LowerBound:
-				if (entry.score >= beta)
+				if (entry->score >= beta)
 				{
-					return entry.score;
+					return entry->score;
 				}
 				else
 				{
 					break;
 				}
 			case TranspositionBound::UpperBound:
-				if (entry.score <= alpha)
+				if (entry->score <= alpha)
 				{
-					return entry.score;
+					return entry->score;
 				}
 				else
 				{
@@ -89,88 +444,389 @@ export class Solver
 		}
 		if (blue)
 		{
-			int total_spawn_score = 0;
-			int count = 0;
 			auto possible_spawns = state.get_possible_spawns() | std::ranges::to<std::vector>();
-			int children = std::min<int>(5, possible_spawns.size());
-			for (int i = 0; i < children; ++i)
-			{
-				std::ranges::swap(possible_spawns[i], possible_spawns[rand() % (possible_spawns.size() - i) + i]);
-				auto idx = possible_spawns[i];
-				state.set(idx, Cell::Blue);
-				total_spawn_score += evaluate(false, depth, alpha, beta);
-				state.unset(idx);
-				++count;
-			}
-			int avg_spawn_score = total_spawn_score / count;
-			int no_spawn_score = evaluate(false, depth, alpha, beta);
-			// There is a 1/6 chance of actually having a spawn
-			int score = (5 * no_spawn_score + avg_spawn_score) / 6;
+			// A blue out of reach of every piece for the rest of the search takes part in no capture and no
+			// evaluation term, so one such spawn stands for all of them. A network takes every blue as an input, so
+			// with one every spawn counts as reachable.
+			auto const distances = state.piece_distances();
+			int const reach = _network ? std::numeric_limits<std::uint8_t>::max() : spawn_reach(depth, distances);
+			auto const unreachable = std::ranges::partition(
+				possible_spawns, [&](auto idx) { return distances[idx] <= reach; });
+			auto const reachable_count = static_cast<int>(possible_spawns.size() - unreachable.size());
+			auto const unreachable_count = static_cast<int>(unreachable.size());
+			int const spawn_count = reachable_count + unreachable_count;
+
+			// There is a 1/6 chance of actually having a spawn, spread evenly over the possible spawns, with a sample
+			// standing in for the reachable ones. The weights share one denominator, so that the score is the weighted
+			// sum of the children's scores divided once.
+			int const sampled = std::min(5, reachable_count);
+			std::int64_t const per_sample = std::max(sampled, 1);
+			std::int64_t const denominator = spawn_count == 0 ? 1 : 6 * spawn_count * per_sample;
+			std::array<ChanceChild, 7> children;
+			std::size_t child_count = 0;
+			children[child_count++] = {std::nullopt, spawn_count == 0 ? 1 : 5 * spawn_count * per_sample};
+			// Sampling depends only on the position, so re-searches see the same spawns
+			std::minstd_rand engine{static_cast<std::uint32_t>(hash ^ (hash >> 32))};
+			for (int i = 0; i < sampled; ++i)
+			{
+				std::ranges::swap(possible_spawns[i], possible_spawns[engine() % (reachable_count - i) + i]);
+				children[child_count++] = {possible_spawns[i], reachable_count};
+			}
+			if (unreachable_count > 0)
+			{
+				_stats.collapsed_spawns += unreachable_count - 1;
+				children[child_count++] = {unreachable.front(), unreachable_count * per_sample};
+			}
+
+			std::size_t const outer_repetition_index = std::exchange(_repetition_index, no_repetition);
+			// Children failing to one side of the window bound the score only together with those failing to the same
+			// side, so the weighted bounds of all children decide whether the score falls outside the window
+			std::int64_t lower = 0;
+			std::int64_t upper = 0;
+			for (auto &child : children | std::views::take(child_count))
+			{
+				search_chance_child(child, depth, alpha, beta);
+				lower += child.weight * child.lower;
+				upper += child.weight * child.upper;
+			}
+			// Otherwise the children not known exactly are searched again, each with the window outside of which the
+			// score falls outside the node's whatever the other children score within their bounds
+			for (auto &child : children | std::views::take(child_count))
+			{
+				if (_aborted or upper <= alpha * denominator or lower >= beta * denominator)
+				{
+					break;
+				}
+				else if (child.lower == child.upper)
+				{
+					continue;
+				}
+				lower -= child.weight * child.lower;
+				upper -= child.weight * child.upper;
+				auto const child_alpha = static_cast<int>(std::clamp<std::int64_t>(
+					floor_div(alpha * denominator - upper, child.weight), -score_infinity - 1, score_infinity));
+				auto const child_beta = static_cast<int>(std::clamp<std::int64_t>(
+					ceil_div(beta * denominator - lower, child.weight), -score_infinity, score_infinity + 1));
+				search_chance_child(child, depth, child_alpha, child_beta);
+				lower += child.weight * child.lower;
+				upper += child.weight * child.upper;
+			}
+			// Scores are rounded towards zero, which keeps each bound on its side of the window
+			int score = static_cast<int>(lower / denominator);
+			auto bound = TranspositionBound::Exact;
+			if (lower != upper and upper <= alpha * denominator)
+			{
+				score = static_cast<int>(upper / denominator);
+				bound = TranspositionBound::UpperBound;
+			}
+			else if (lower != upper)
+			{
+				bound = TranspositionBound::LowerBound;
+			}
+			std::size_t const repetition_index = std::exchange(
+				_repetition_index, std::min(outer_repetition_index, _repetition_index));
+			if (_aborted)
+			{
+				return 0;
+			}
+			if (repetition_index >= _path.size())
+			{
+				_transposition_table.store(key, {.score = score, .depth = depth, .bound = bound});
+			}
 			return score;
 		}
 		else if (depth > 0)
 		{
-			int score = std::numeric_limits<int>::min();
-			for (Move move : state.get_legal_moves())
+			if (depth >= enhanced_cutoff_min_depth)
 			{
-				state.commit(move);
-				score = std::max(score, -evaluate(true, depth - 1, -beta, -alpha));
-				state.uncommit(move);
-				if (score >= beta)
+				if (auto cutoff = enhanced_transposition_cutoff(depth, beta))
+				{
+					++_stats.enhanced_cutoffs;
+					store_transposition(hash, depth, cutoff->second, original_alpha, original_beta, cutoff->first);
+					return cutoff->second;
+				}
+			}
+			// Having no legal moves loses the game
+			int score = -score_infinity;
+			std::optional<Move> best_move;
+			// A quiet move leaves the material alone, so at the frontier it cannot make up more than the margin
+			int const futility_score = _options.futility_pruning and depth == 1
+				? static_evaluation() + _options.futility_margin
+				: score_infinity;
+			int searched = 0;
+			std::size_t const index = _path.size();
+			_path.push_back(hash);
+			std::size_t const outer_repetition_index = std::exchange(_repetition_index, no_repetition);
+			auto moves = ordered_moves();
+			for (auto next = moves.begin(); next != moves.end();)
+			{
+				Move const move = *next;
+				// The next child's entry loads while this one is searched
+				if (++next != moves.end())
+				{
+					_transposition_table.prefetch(state.hash_after(*next) ^ chance_node_key);
+				}
+				bool const quiet = move.blue_flags == 0;
+				if (quiet and futility_score <= alpha)
+				{
+					++_stats.futility_prunes;
+					score = std::max(score, futility_score);
+					continue;
+				}
+				int const reduction = _options.late_move_reductions and quiet
+						and depth >= _options.reduction_min_depth and searched >= _options.reduction_move_count
+					? 1
+					: 0;
+				commit(move);
+				int const move_score = searched == 0 ? -evaluate(true, depth - 1, -beta, -alpha)
+													 : search_null_window(depth - 1, reduction, alpha, beta);
+				uncommit(move);
+				if (move_score > score)
+				{
+					score = move_score;
+					best_move = move;
+				}
+				++searched;
+				if (score >= beta or _aborted)
 				{
 					break;
 				}
 				alpha = std::max(alpha, score);
 			}
-			entry.bound = (score <= original_alpha) //
-				? TranspositionBound::UpperBound
-				: (score >= original_beta) //
-					? TranspositionBound::LowerBound
-					: entry.bound = TranspositionBound::Exact;
-			entry.is_valid = true;
-			entry.score = score;
-			entry.depth = depth;
+			_path.pop_back();
+			std::size_t const repetition_index = std::exchange(
+				_repetition_index, std::min(outer_repetition_index, _repetition_index));
+			if (_aborted)
+			{
+				return 0;
+			}
+			// A score relying on a repetition of an earlier position only holds on this search line
+			if (repetition_index < index)
+			{
+				return score;
+			}
+			// Failing low proves every move bad without finding the best
+			store_transposition(
+				hash, depth, score, original_alpha, original_beta, score > original_alpha ? best_move : std::nullopt);
 			return score;
 		}
 		else
 		{
-			++_leaf_nodes;
-			int score = state.heuristic();
-			entry.bound = TranspositionBound::Exact;
-			entry.is_valid = true;
-			entry.score = score;
-			entry.depth = 0;
-			return score;
+			++_stats.leaf_nodes;
+			// Leaves go to the evaluation cache instead of the transposition table
+			return _options.quiescence ? quiescence(alpha, beta) : static_evaluation();
 		}
 	}
 
-	enum class TranspositionBound : std::uint8_t
+	/// Searches the child of a chance node with the given window, narrowing its bounds to the score found. Scores
+	/// beyond won and lost games are cut to them, so that every child's score lies within the widest bounds.
+	void search_chance_child(ChanceChild &child, int depth, int alpha, int beta)
 	{
-		Exact,
-		LowerBound,
-		UpperBound,
-	};
+		if (child.spawn)
+		{
+			spawn(*child.spawn);
+		}
+		int const score = std::clamp(evaluate(false, depth, alpha, beta), -score_infinity, score_infinity);
+		if (child.spawn)
+		{
+			unspawn(*child.spawn);
+		}
+		if (score > alpha)
+		{
+			child.lower = score;
+		}
+		if (score < beta)
+		{
+			child.upper = score;
+		}
+	}
+
+	/// The largest distance from the pieces at which a blue spawned now can still matter. Each ply places one piece
+	/// next to one already on the board, and a blue is captured, or changes the evaluation, from two steps away.
+	/// The quiescence search adds at most a ply per blue. Blues spawned deeper in the search are not accounted for.
+	int spawn_reach(int depth, std::array<std::uint8_t, State::num_cells> const &distances) const
+	{
+		int reach = depth + 2;
+		if (_options.quiescence)
+		{
+			auto const pieces = static_cast<int>(std::ranges::count(distances, 0));
+			// The blue about to spawn is the one more
+			reach += pieces - state.green_count() - state.purple_count() + 1;
+		}
+		return reach;
+	}
+
+	/// A move whose chance node the transposition table already proves to score at least beta for the player to move,
+	/// found before searching any move, with that score. Only the first moves in search order are probed, captures
+	/// being the likeliest to cut off, so that the probes cost a fraction of a move loop.
+	std::optional<std::pair<Move, int>> enhanced_transposition_cutoff(int depth, int beta) const
+	{
+		for (Move move : ordered_moves() | std::views::take(enhanced_cutoff_moves))
+		{
+			auto entry = _transposition_table.probe(state.hash_after(move) ^ chance_node_key);
+			if (entry and entry->depth >= depth - 1 and entry->bound != TranspositionBound::LowerBound
+				and -entry->score >= beta)
+			{
+				return std::pair{move, -entry->score};
+			}
+		}
+		return std::nullopt;
+	}
 
-	struct TranspositionTableEntry
+	/// Captures first, so the moves late in the order are the quiet ones
+	std::generator<Move> ordered_moves() const
 	{
-		bool is_valid;
-		TranspositionBound bound;
-		int depth;
+		if (_options.max_sources > 0)
+		{
+			for (Move move : state.grouped_moves(_options.max_sources, CaptureTargets{}))
+			{
+				co_yield move;
+			}
+			for (Move move : state.grouped_moves(_options.max_sources, QuietTargets{}))
+			{
+				co_yield move;
+			}
+		}
+		else
+		{
+			for (Move move : state.moves(CaptureTargets{}))
+			{
+				co_yield move;
+			}
+			for (Move move : state.moves(QuietTargets{}))
+			{
+				co_yield move;
+			}
+		}
+	}
+
+	/// Searches only blue captures, letting the player to move stand pat on the static evaluation.
+	/// Every capture removes a blue, so the search ends without a depth limit. Spawns are not considered.
+	int quiescence(int alpha, int beta)
+	{
+		++_stats.quiescence_nodes;
+		int score = static_evaluation();
+		if (score >= beta)
+		{
+			return score;
+		}
+		alpha = std::max(alpha, score);
+		for (Move move : state.get_capture_moves())
+		{
+			commit(move);
+			score = std::max(score, -quiescence(-beta, -alpha));
+			uncommit(move);
+			if (score >= beta)
+			{
+				break;
+			}
+			alpha = std::max(alpha, score);
+		}
+		return score;
+	}
+
+	/// The heuristic score of the position, from the evaluation cache when it was seen before
+	int static_evaluation()
+	{
+		++_stats.evaluations;
+		auto hash = state.hash();
+		if (auto cached = _evaluation_cache.probe(hash))
+		{
+			++_stats.evaluation_cache_hits;
+			return *cached;
+		}
 		int score;
-	};
+		if (_network)
+		{
+			// Bounded well inside the scores of won and lost games
+			int const network_score = _network->evaluate(_accumulators.back(), state.turn());
+			score = std::clamp(network_score, -score_infinity / 2, score_infinity / 2);
+		}
+		else
+		{
+			score = state.heuristic();
+		}
+		_evaluation_cache.store(hash, score);
+		return score;
+	}
 
-	TranspositionTableEntry &get_transposition_entry(std::uint64_t key)
+	/// Makes a move in the searched position, keeping the network's first layer in step
+	void commit(Move move)
 	{
-		return _transposition_table[key % _transposition_table_size];
+		if (_network)
+		{
+			_accumulators.push_back(_accumulators.back());
+			_network->commit(_accumulators.back(), state, move);
+		}
+		state.commit(move);
 	}
 
-	GameState state;
-	std::minstd_rand _engine{};
-	std::size_t _transposition_table_size;
-	std::unique_ptr<TranspositionTableEntry[]> _transposition_table;
-	std::size_t _nodes = 0;
-	std::size_t _leaf_nodes = 0;
-	std::size_t _transposition_table_hits = 0;
+	void uncommit(Move move)
+	{
+		state.uncommit(move);
+		if (_network)
+		{
+			_accumulators.pop_back();
+		}
+	}
+
+	void spawn(State::Index idx)
+	{
+		if (_network)
+		{
+			_accumulators.push_back(_accumulators.back());
+			_network->add(_accumulators.back(), idx, Cell::Blue);
+		}
+		state.set(idx, Cell::Blue);
+	}
+
+	void unspawn(State::Index idx)
+	{
+		state.unset(idx);
+		if (_network)
+		{
+			_accumulators.pop_back();
+		}
+	}
+
+	void store_transposition(
+		std::uint64_t hash, int depth, int score, int alpha, int beta, std::optional<Move> best_move = std::nullopt)
+	{
+		_transposition_table.store(
+			hash,
+			{
+				.score = score,
+				.depth = depth,
+				.bound = (score <= alpha) //
+					? TranspositionBound::UpperBound
+					: (score >= beta) //
+						? TranspositionBound::LowerBound
+						: TranspositionBound::Exact,
+				.best_from = static_cast<std::uint16_t>(best_move ? best_move->from : 0),
+				.best_to = static_cast<std::uint16_t>(best_move ? best_move->to : 0),
+			});
+	}
+
+	/// Distinguishes the key of a chance node from that of the same position with the player to move
+	static constexpr std::uint64_t chance_node_key = zobrist_table<State::num_cells>.is_blue_move_hash;
+
+	State state;
+	SearchOptions _options;
+	TranspositionTable _transposition_table;
+	EvaluationCache _evaluation_cache;
+	SearchStats _stats;
+	std::stop_token _stop;
+	bool _aborted = false;
+	/// Hashes of the decision nodes on the current search line, from the root
+	std::vector<std::uint64_t> _path;
+	/// Lowest search line index repeated in the current subtree
+	std::size_t _repetition_index = no_repetition;
+	std::shared_ptr<Network const> _network;
+	/// First layers of the network along the search line, the searched position's last
+	std::vector<NetworkAccumulator> _accumulators;
 };
 
+export using solve_result = basic_solve_result<rows, cols>;
+export using Solver = BasicSolver<rows, cols>;
+
 } // namespace flit
\ No newline at end of file
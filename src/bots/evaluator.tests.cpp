@@ -1,8 +1,13 @@
 #include <catch2/catch_test_macros.hpp>
 #include <libassert/assert-catch2.hpp>
 
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
 import flit.game;
 import flit.evaluator;
+import flit.huge_pages;
 
 TEST_CASE("Best move should be immediate capture", "[evaluator]")
 {
@@ -58,4 +63,240 @@ TEST_CASE("Should capture blue before opponent", "[evaluator]")
 	auto [best_move, score] = results[0];
 	ASSERT(best_move.from == flit::from_rc(4, 8));
 	ASSERT(best_move.to == flit::from_rc(6, 8));
+}
+
+TEST_CASE("Selective search should search fewer nodes", "[evaluator]")
+{
+	flit::GameState state{};
+	state.set(4, 8, flit::Cell::Green);
+	state.set(5, 8, flit::Cell::Green);
+	state.set(4, 10, flit::Cell::Blue);
+	state.set(8, 8, flit::Cell::Blue);
+	state.set(8, 5, flit::Cell::Purple);
+	state.set(8, 4, flit::Cell::Purple);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	flit::Solver full{state};
+	full.solve(flit::Cell::Green, 3);
+
+	// Futility pruning only skips quiet moves that cannot reach alpha, so the best move stays the same
+	flit::Solver futility{state, 1 << 25, {.futility_pruning = true}};
+	auto results = futility.solve(flit::Cell::Green, 3);
+	ASSERT(results.size() > 0);
+	auto [best_move, score] = results[0];
+	ASSERT(best_move.from == flit::from_rc(4, 8));
+	ASSERT(best_move.to == flit::from_rc(6, 8));
+	ASSERT(futility.stats().futility_prunes > 0);
+	ASSERT(futility.stats().nodes < full.stats().nodes);
+
+	flit::Solver reduced{state, 1 << 25, {.late_move_reductions = true}};
+	reduced.solve(flit::Cell::Green, 3);
+	ASSERT(reduced.stats().reductions > 0);
+	ASSERT(reduced.stats().nodes < full.stats().nodes);
+}
+
+TEST_CASE("Multi-PV search proves the best few moves", "[evaluator]")
+{
+	flit::GameState state{};
+	state.set(4, 8, flit::Cell::Green);
+	state.set(5, 8, flit::Cell::Green);
+	state.set(4, 10, flit::Cell::Blue);
+	state.set(8, 8, flit::Cell::Blue);
+	state.set(8, 5, flit::Cell::Purple);
+	state.set(8, 4, flit::Cell::Purple);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	flit::Solver single{state, 1 << 20};
+	auto best = single.solve(flit::Cell::Green, 2);
+	flit::Solver multi{state, 1 << 20, {.multipv = 3}};
+	auto ranked = multi.solve(flit::Cell::Green, 2);
+
+	ASSERT(ranked[0].move == best[0].move);
+	ASSERT(ranked[0].score == best[0].score);
+	ASSERT(ranked[1].score <= ranked[0].score);
+	ASSERT(ranked[2].score <= ranked[1].score);
+	// Proving more moves exactly costs more
+	ASSERT(single.stats().nodes < multi.stats().nodes);
+
+	auto line = multi.principal_variation(ranked[0].move, 3);
+	ASSERT(line.size() == 3);
+	ASSERT(line[0] == ranked[0].move);
+	ASSERT(single.principal_variation(best[0].move, 3) == line);
+}
+
+TEST_CASE("Null window searches agree with full window ones", "[evaluator]")
+{
+	using State = flit::BasicGameState<6, 6>;
+	std::mt19937 engine{5};
+	for (int i = 0; i < 20; ++i)
+	{
+		State state = flit::random_start<State>(engine);
+		for (int ply = 0; ply < 6 and state.winner() == flit::Cell::Empty; ++ply)
+		{
+			state.commit(*state.random_legal_move(engine));
+			state.maybe_spawn_blue(engine);
+		}
+		if (state.winner() != flit::Cell::Empty)
+		{
+			continue;
+		}
+		INFO(flit::dump(state));
+
+		// Every root move of the second search gets a full window, while the first proves most of them worse with
+		// null windows, at chance nodes as well
+		flit::BasicSolver<6, 6> single{state, 1 << 14};
+		auto best = single.solve(state.turn(), 2);
+		flit::BasicSolver<6, 6> exact{state, 1 << 14, {.multipv = static_cast<int>(best.size())}};
+		auto ranked = exact.solve(state.turn(), 2);
+		ASSERT(best[0].score == ranked[0].score);
+	}
+}
+
+TEST_CASE("Quiescence search should see captures past the horizon", "[evaluator]")
+{
+	flit::GameState state{};
+	state.set(4, 5, flit::Cell::Green);
+	state.set(5, 5, flit::Cell::Green);
+	state.set(0, 0, flit::Cell::Purple);
+	state.set(0, 1, flit::Cell::Purple);
+	state.set(0, 3, flit::Cell::Blue);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	flit::Solver static_evaluator{state, 1 << 25, {.quiescence = false}};
+	auto static_results = static_evaluator.solve(flit::Cell::Green, 0);
+	flit::Solver evaluator{state};
+	auto results = evaluator.solve(flit::Cell::Green, 0);
+	ASSERT(results.size() > 0);
+	// Whatever green does, purple captures the blue next
+	ASSERT(results[0].score < static_results[0].score);
+	ASSERT(evaluator.stats().quiescence_nodes > 0);
+}
+
+TEST_CASE("Repeated leaves are evaluated from the cache", "[evaluator]")
+{
+	flit::GameState state{};
+	state.set(4, 5, flit::Cell::Green);
+	state.set(5, 5, flit::Cell::Green);
+	state.set(0, 0, flit::Cell::Purple);
+	state.set(0, 1, flit::Cell::Purple);
+	state.set(0, 3, flit::Cell::Blue);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	flit::Solver solver{state, 1 << 16};
+	auto results = solver.solve(flit::Cell::Green, 2);
+	ASSERT(results.size() > 0);
+	auto const &stats = solver.stats();
+	ASSERT(stats.evaluations >= stats.leaf_nodes);
+	// Spawns that do not change the leaf and transposed moves reach the same positions
+	ASSERT(stats.evaluation_cache_hits > 0);
+	ASSERT(stats.evaluation_cache_hits < stats.evaluations);
+}
+
+TEST_CASE("Spawns out of reach are evaluated as one", "[evaluator]")
+{
+	flit::GameState state{};
+	state.set(0, 0, flit::Cell::Green);
+	state.set(0, 1, flit::Cell::Green);
+	state.set(1, 4, flit::Cell::Purple);
+	state.set(1, 5, flit::Cell::Purple);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	flit::Solver solver{state, 1 << 16};
+	auto results = solver.solve(flit::Cell::Green, 1);
+	ASSERT(results.size() > 0);
+	// Most of the board is more than a few steps from the four pieces
+	ASSERT(solver.stats().collapsed_spawns > 0);
+}
+
+TEST_CASE("Chance nodes are kept in the transposition table", "[evaluator]")
+{
+	flit::GameState state{};
+	state.set(4, 5, flit::Cell::Green);
+	state.set(5, 5, flit::Cell::Green);
+	state.set(0, 0, flit::Cell::Purple);
+	state.set(0, 1, flit::Cell::Purple);
+	state.set(0, 3, flit::Cell::Blue);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	flit::Solver solver{state, 1 << 16};
+	auto cold = solver.solve(flit::Cell::Green, 2);
+	std::size_t const cold_nodes = solver.stats().nodes;
+	solver.reset(state);
+	auto warm = solver.solve(flit::Cell::Green, 2);
+	ASSERT(warm[0].move == cold[0].move);
+	ASSERT(warm[0].score == cold[0].score);
+	// The root moves' chance nodes answer from the table without sampling their spawns again
+	ASSERT(solver.stats().nodes * 4 < cold_nodes);
+}
+
+TEST_CASE("Shuffling pieces repeat positions on the search line", "[evaluator]")
+{
+	flit::BasicGameState<6, 6> state{};
+	state.set(0, 0, flit::Cell::Green);
+	state.set(0, 1, flit::Cell::Green);
+	state.set(3, 3, flit::Cell::Purple);
+	state.set(3, 4, flit::Cell::Purple);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	// Green and purple each move a piece away and back, which takes four plies past the root
+	flit::BasicSolver<6, 6> solver{state, 1 << 16};
+	auto results = solver.solve(flit::Cell::Green, 4);
+	ASSERT(results.size() > 0);
+	ASSERT(solver.stats().repetitions > 0);
+
+	flit::BasicSolver<6, 6> shallow{state, 1 << 16};
+	shallow.solve(flit::Cell::Green, 2);
+	ASSERT(shallow.stats().repetitions == 0);
+}
+
+TEST_CASE("Solver works on small boards", "[evaluator]")
+{
+	flit::BasicGameState<6, 6> state{};
+	state.set(2, 2, flit::Cell::Green);
+	state.set(3, 2, flit::Cell::Green);
+	state.set(5, 2, flit::Cell::Blue);
+	state.set(0, 4, flit::Cell::Purple);
+	state.set(0, 5, flit::Cell::Purple);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+	flit::BasicSolver<6, 6> evaluator{state, 1 << 16};
+
+	auto results = evaluator.solve(flit::Cell::Green, 2);
+	ASSERT(results.size() > 0);
+	auto [best_move, score] = results[0];
+	ASSERT(best_move.from == flit::Board<6, 6>::from_rc(2, 2));
+	ASSERT(best_move.to == flit::Board<6, 6>::from_rc(4, 2));
+}
+
+TEST_CASE("Transposition table is sized in megabytes", "[evaluator]")
+{
+	std::size_t const entries = flit::Solver::transposition_table_entries(16);
+	ASSERT(entries > 0);
+	ASSERT(flit::Solver::transposition_table_entries(32) / 2 == entries);
+
+	flit::HugePageArray<std::uint64_t> table{flit::huge_page_size / sizeof(std::uint64_t) + 1};
+	ASSERT(table.size() == flit::huge_page_size / sizeof(std::uint64_t) + 1);
+	for (std::size_t i = 0; i < table.size(); i += 4096)
+	{
+		ASSERT(table[i] == 0);
+	}
+	table[table.size() - 1] = 1;
+	ASSERT(table[table.size() - 1] == 1);
+
+	flit::GameState state{};
+	state.set(4, 5, flit::Cell::Green);
+	state.set(5, 5, flit::Cell::Green);
+	state.set(7, 5, flit::Cell::Blue);
+	state.set(0, 0, flit::Cell::Purple);
+	state.set(0, 1, flit::Cell::Purple);
+	flit::Solver evaluator{state, entries};
+	auto results = evaluator.solve(flit::Cell::Green, 1);
+	ASSERT(results.size() > 0);
 }
\ No newline at end of file
@@ -0,0 +1,447 @@
+module;
+
+#include <libassert/assert.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+
+export module flit.bots.mctsbot;
+
+import flit.bots.base;
+import flit.playout;
+
+namespace flit::bots
+{
+
+export struct MctsOptions
+{
+	/// Thinking time per move, or zero to search until max_playouts is reached
+	std::chrono::milliseconds time{200};
+	/// Stops a search after this many playouts, if non-zero
+	std::size_t max_playouts = 0;
+	unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+	std::size_t max_nodes = 1 << 22;
+	/// Spawn cells considered at each chance node besides the no-spawn outcome
+	int spawn_samples = 4;
+	/// Playouts stop after this many plies and score the position with the heuristic
+	int playout_depth = 40;
+	/// Heuristic score that maps to a 73% playout reward
+	float playout_scale = 1000;
+	float exploration = 0.7f;
+	/// Seeds the random engines of the search threads; with one thread, a fixed seed makes searches repeatable
+	std::uint64_t seed = std::random_device{}();
+};
+
+export struct MctsStats
+{
+	std::size_t playouts = 0;
+	std::size_t nodes = 0;
+	std::chrono::milliseconds time{};
+	/// Whether the search started from a subtree of the previous search
+	bool reused_tree = false;
+};
+
+namespace
+{
+
+enum class NodeKind : std::uint8_t
+{
+	/// A player is to move; children are chance nodes, one per legal move
+	Decision,
+	/// A move has been made; children are decision nodes, one per sampled spawn outcome
+	Chance,
+};
+
+enum class Expansion : std::uint8_t
+{
+	Leaf,
+	Expanding,
+	Expanded,
+};
+
+constexpr std::uint_fast8_t no_spawn = std::numeric_limits<std::uint_fast8_t>::max();
+
+struct Node
+{
+	std::atomic<std::uint32_t> visits;
+	std::atomic<std::uint32_t> virtual_loss;
+	/// Sum of playout rewards from green's perspective, each in [0, 1]
+	std::atomic<float> green_reward;
+	std::atomic<Expansion> expansion;
+	NodeKind kind;
+	/// Move leading to a chance node
+	Move move;
+	/// Spawn cell leading to a decision node, or no_spawn
+	std::uint_fast8_t spawn;
+	std::uint32_t first_child;
+	std::uint32_t child_count;
+	/// Hash of the position at a decision node, used to find it again when reusing the tree
+	std::uint64_t hash;
+
+	void reset(NodeKind new_kind)
+	{
+		visits.store(0, std::memory_order_relaxed);
+		virtual_loss.store(0, std::memory_order_relaxed);
+		green_reward.store(0, std::memory_order_relaxed);
+		expansion.store(Expansion::Leaf, std::memory_order_relaxed);
+		kind = new_kind;
+		move = {};
+		spawn = no_spawn;
+		first_child = 0;
+		child_count = 0;
+		hash = 0;
+	}
+};
+
+/// Fixed-capacity arena of nodes, shared by all search threads
+class NodePool
+{
+  public:
+	explicit NodePool(std::size_t capacity) : _capacity{capacity}, _nodes{std::make_unique<Node[]>(capacity)} {}
+
+	/// Reserves `count` contiguous nodes, or returns nothing once the pool is exhausted
+	std::optional<std::uint32_t> allocate(std::size_t count)
+	{
+		std::size_t first = _size.fetch_add(count, std::memory_order_relaxed);
+		if (first + count > _capacity)
+		{
+			return std::nullopt;
+		}
+		return static_cast<std::uint32_t>(first);
+	}
+
+	Node &operator[](std::uint32_t idx) { return _nodes[idx]; }
+	Node const &operator[](std::uint32_t idx) const { return _nodes[idx]; }
+
+	std::size_t size() const { return std::min(_size.load(std::memory_order_relaxed), _capacity); }
+	std::size_t capacity() const { return _capacity; }
+	void clear() { _size.store(0, std::memory_order_relaxed); }
+
+  private:
+	std::size_t _capacity;
+	std::unique_ptr<Node[]> _nodes;
+	std::atomic<std::size_t> _size = 0;
+};
+
+/// Per-thread scratch space, so iterations do not allocate once warmed up
+struct Worker
+{
+	std::mt19937_64 engine;
+	std::vector<std::uint32_t> path;
+	std::vector<Move> moves;
+	std::vector<std::uint_fast8_t> spawns;
+};
+
+} // namespace
+
+/// Monte-Carlo tree search with UCT selection, chance nodes for blue spawns and tree parallelism
+export class MctsBot : public Bot
+{
+  public:
+	explicit MctsBot(MctsOptions options = {}) : _options{options}, _pool{options.max_nodes}, _seeds{options.seed} {}
+
+	Move choose_move(GameState game) override
+	{
+		LIBASSERT_ASSERT(game.has_legal_moves());
+		auto begin = std::chrono::steady_clock::now();
+		_stats = {};
+		_stats.reused_tree = reuse_tree(game);
+		if (not _stats.reused_tree)
+		{
+			_pool.clear();
+			_root = *_pool.allocate(1);
+			_pool[_root].reset(NodeKind::Decision);
+			_pool[_root].hash = game.hash();
+		}
+
+		search(
+			game,
+			_options.time.count() > 0 ? begin + _options.time : std::chrono::steady_clock::time_point::max());
+
+		Node &root = _pool[_root];
+		std::optional<std::uint32_t> best;
+		if (root.expansion.load(std::memory_order_acquire) == Expansion::Expanded)
+		{
+			for (std::uint32_t idx = root.first_child; idx < root.first_child + root.child_count; ++idx)
+			{
+				if (not best or _pool[idx].visits > _pool[*best].visits)
+				{
+					best = idx;
+				}
+			}
+		}
+		_stats.nodes = _pool.size();
+		_stats.time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin);
+		if (not best)
+		{
+			// Not a single iteration completed; fall back to the first legal move
+			_previous_root.reset();
+			return *game.get_legal_moves().begin();
+		}
+		_last_move = _pool[*best].move;
+		_previous_root = _root;
+		return _last_move;
+	}
+
+	MctsStats const &stats() const { return _stats; }
+
+	void time(std::chrono::milliseconds time) { _options.time = time; }
+
+  private:
+	/// Makes the decision node for `game` the root if the previous search already reached it
+	bool reuse_tree(GameState const &game)
+	{
+		if (not _previous_root or _pool.size() > _pool.capacity() / 2)
+		{
+			return false;
+		}
+		// Our move, a spawn outcome, the opponent's move and another spawn outcome
+		std::vector<std::uint32_t> frontier{*_previous_root};
+		for (int level = 0; level < 4; ++level)
+		{
+			std::vector<std::uint32_t> next;
+			for (std::uint32_t idx : frontier)
+			{
+				Node &node = _pool[idx];
+				if (node.expansion.load(std::memory_order_acquire) != Expansion::Expanded)
+				{
+					continue;
+				}
+				for (std::uint32_t child = node.first_child; child < node.first_child + node.child_count; ++child)
+				{
+					if (level == 0 and _pool[child].move != _last_move)
+					{
+						continue;
+					}
+					if (_pool[child].kind == NodeKind::Decision and _pool[child].hash == game.hash())
+					{
+						_root = child;
+						return true;
+					}
+					next.push_back(child);
+				}
+			}
+			frontier = std::move(next);
+		}
+		return false;
+	}
+
+	void search(GameState const &game, std::chrono::steady_clock::time_point deadline)
+	{
+		std::atomic<std::size_t> started = 0;
+		std::atomic<std::size_t> completed = 0;
+		{
+			std::vector<std::jthread> threads;
+			for (unsigned i = 0; i < _options.threads; ++i)
+			{
+				threads.emplace_back(
+					[&, seed = _seeds()]
+					{
+						Worker worker{.engine = std::mt19937_64{seed}};
+						while (std::chrono::steady_clock::now() < deadline)
+						{
+							if (_options.max_playouts != 0 and started.fetch_add(1) >= _options.max_playouts)
+							{
+								break;
+							}
+							iterate(game, worker);
+							completed.fetch_add(1, std::memory_order_relaxed);
+						}
+					});
+			}
+		}
+		_stats.playouts = completed.load();
+	}
+
+	/// Runs one selection, expansion, playout and backpropagation pass
+	void iterate(GameState state, Worker &worker)
+	{
+		worker.path.clear();
+		std::uint32_t idx = _root;
+		float green_reward;
+		while (true)
+		{
+			Node &node = _pool[idx];
+			worker.path.push_back(idx);
+			node.virtual_loss.fetch_add(1, std::memory_order_relaxed);
+
+			if (node.kind == NodeKind::Decision)
+			{
+				if (Cell winner = state.winner(); winner != Cell::Empty)
+				{
+					green_reward = winner == Cell::Green ? 1.0f : 0.0f;
+					break;
+				}
+			}
+			if (node.expansion.load(std::memory_order_acquire) != Expansion::Expanded)
+			{
+				if (node.kind == NodeKind::Decision)
+				{
+					// A new leaf is scored by a playout; its children are visited by later iterations
+					expand(node, state, worker);
+					green_reward = playout(state, worker);
+					break;
+				}
+				else if (not expand(node, state, worker))
+				{
+					green_reward = playout(state, worker);
+					break;
+				}
+			}
+
+			if (node.kind == NodeKind::Decision)
+			{
+				idx = select(node, state.turn());
+				state.commit(_pool[idx].move);
+			}
+			else
+			{
+				idx = node.first_child;
+				if (node.child_count > 1
+					and std::uniform_int_distribution<int>{1, blue_spawn_odds}(worker.engine) == 1)
+				{
+					idx += std::uniform_int_distribution<std::uint32_t>{1, node.child_count - 1}(worker.engine);
+					state.set(_pool[idx].spawn, Cell::Blue);
+				}
+			}
+		}
+
+		for (std::uint32_t visited : worker.path)
+		{
+			Node &node = _pool[visited];
+			node.green_reward.fetch_add(green_reward, std::memory_order_relaxed);
+			node.visits.fetch_add(1, std::memory_order_relaxed);
+			node.virtual_loss.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+
+	/// Creates the children of a leaf. Returns false if another thread is expanding it or the pool is full.
+	bool expand(Node &node, GameState &state, Worker &worker)
+	{
+		Expansion expected = Expansion::Leaf;
+		if (not node.expansion.compare_exchange_strong(expected, Expansion::Expanding, std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		std::optional<std::uint32_t> first;
+		if (node.kind == NodeKind::Decision)
+		{
+			worker.moves.clear();
+			for (Move move : state.get_legal_moves())
+			{
+				worker.moves.push_back(move);
+			}
+			first = _pool.allocate(worker.moves.size());
+			if (first)
+			{
+				for (std::uint32_t i = 0; i < worker.moves.size(); ++i)
+				{
+					Node &child = _pool[*first + i];
+					child.reset(NodeKind::Chance);
+					child.move = worker.moves[i];
+				}
+				node.child_count = static_cast<std::uint32_t>(worker.moves.size());
+			}
+		}
+		else
+		{
+			worker.spawns.clear();
+			for (std::uint_fast8_t spawn : state.get_possible_spawns())
+			{
+				worker.spawns.push_back(spawn);
+			}
+			std::size_t samples = std::min<std::size_t>(_options.spawn_samples, worker.spawns.size());
+			for (std::size_t i = 0; i < samples; ++i)
+			{
+				std::uniform_int_distribution<std::size_t> dist{i, worker.spawns.size() - 1};
+				std::ranges::swap(worker.spawns[i], worker.spawns[dist(worker.engine)]);
+			}
+			first = _pool.allocate(1 + samples);
+			if (first)
+			{
+				Node &no_spawn_child = _pool[*first];
+				no_spawn_child.reset(NodeKind::Decision);
+				no_spawn_child.hash = state.hash();
+				for (std::uint32_t i = 0; i < samples; ++i)
+				{
+					Node &child = _pool[*first + 1 + i];
+					child.reset(NodeKind::Decision);
+					child.spawn = worker.spawns[i];
+					state.set(child.spawn, Cell::Blue);
+					child.hash = state.hash();
+					state.unset(child.spawn);
+				}
+				node.child_count = static_cast<std::uint32_t>(1 + samples);
+			}
+		}
+
+		if (not first)
+		{
+			node.expansion.store(Expansion::Leaf, std::memory_order_release);
+			return false;
+		}
+		node.first_child = *first;
+		node.expansion.store(Expansion::Expanded, std::memory_order_release);
+		return true;
+	}
+
+	std::uint32_t select(Node const &node, Cell player) const
+	{
+		float const log_visits = std::log(static_cast<float>(node.visits.load(std::memory_order_relaxed) + 1));
+		std::uint32_t best = node.first_child;
+		float best_score = -std::numeric_limits<float>::infinity();
+		for (std::uint32_t idx = node.first_child; idx < node.first_child + node.child_count; ++idx)
+		{
+			Node const &child = _pool[idx];
+			std::uint32_t visits = child.visits.load(std::memory_order_relaxed);
+			// Virtual losses count as visits without reward, steering other threads elsewhere
+			float effective_visits = static_cast<float>(visits + child.virtual_loss.load(std::memory_order_relaxed));
+			if (effective_visits == 0)
+			{
+				return idx;
+			}
+			float green_reward = child.green_reward.load(std::memory_order_relaxed);
+			float reward = player == Cell::Green ? green_reward : static_cast<float>(visits) - green_reward;
+			float score = reward / effective_visits + _options.exploration * std::sqrt(log_visits / effective_visits);
+			if (score > best_score)
+			{
+				best_score = score;
+				best = idx;
+			}
+		}
+		return best;
+	}
+
+	/// Plays random moves from the position, returning the reward from green's perspective
+	float playout(GameState &state, Worker &worker) const
+	{
+		PlayoutResult result = random_playout(state, worker.engine, _options.playout_depth);
+		if (result.winner != Cell::Empty)
+		{
+			return result.winner == Cell::Green ? 1.0f : 0.0f;
+		}
+		float green_score = static_cast<float>(state.turn() == Cell::Green ? state.heuristic() : -state.heuristic());
+		return 1.0f / (1.0f + std::exp(-green_score / _options.playout_scale));
+	}
+
+	MctsOptions _options;
+	NodePool _pool;
+	/// Draws the seeds of each search's threads, so that successive searches differ
+	std::mt19937_64 _seeds;
+	std::uint32_t _root = 0;
+	std::optional<std::uint32_t> _previous_root;
+	Move _last_move{};
+	MctsStats _stats;
+};
+
+} // namespace flit::bots
\ No newline at end of file
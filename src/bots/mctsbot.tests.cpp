@@ -0,0 +1,105 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <libassert/assert-catch2.hpp>
+
+#include <chrono>
+#include <random>
+
+import flit.game;
+import flit.bots.alphabetabot;
+import flit.bots.mctsbot;
+
+namespace
+{
+
+/// A search of one thread with a fixed seed, so that it plays the same way on every run
+flit::bots::MctsOptions
+fixed_playouts(std::size_t playouts)
+{
+	return {.time = std::chrono::milliseconds{0}, .max_playouts = playouts, .threads = 1, .seed = 1};
+}
+
+} // namespace
+
+TEST_CASE("MCTS prefers an immediate capture", "[mcts]")
+{
+	flit::GameState state{};
+	state.set(4, 5, flit::Cell::Green);
+	state.set(5, 5, flit::Cell::Green);
+	state.set(7, 5, flit::Cell::Blue);
+	state.set(0, 0, flit::Cell::Purple);
+	state.set(0, 1, flit::Cell::Purple);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	flit::bots::MctsBot bot{fixed_playouts(20000)};
+	flit::Move move = bot.choose_move(state);
+	ASSERT(move.to == flit::from_rc(6, 5));
+	ASSERT(bot.stats().playouts == 20000);
+}
+
+TEST_CASE("MCTS reuses the subtree of the position reached", "[mcts]")
+{
+	flit::GameState state{};
+	state.set(4, 5, flit::Cell::Green);
+	state.set(5, 5, flit::Cell::Green);
+	state.set(0, 0, flit::Cell::Purple);
+	state.set(0, 1, flit::Cell::Purple);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	flit::bots::MctsBot bot{fixed_playouts(20000)};
+	state.commit(bot.choose_move(state));
+	ASSERT(not bot.stats().reused_tree);
+	state.commit(*state.get_legal_moves().begin());
+	bot.choose_move(state);
+	ASSERT(bot.stats().reused_tree);
+}
+
+TEST_CASE("MCTS playout throughput", "[.benchmark][mcts]")
+{
+	std::mt19937 engine{1};
+	flit::GameState state = flit::random_start(engine);
+	flit::bots::MctsBot bot{{.time = std::chrono::milliseconds{1000}}};
+	bot.choose_move(state);
+	WARN(
+		"Playouts per second: " << 1000.0 * static_cast<double>(bot.stats().playouts)
+			/ static_cast<double>(bot.stats().time.count()));
+
+	BENCHMARK("1000 playouts") { return flit::bots::MctsBot{fixed_playouts(1000)}.choose_move(state); };
+}
+
+TEST_CASE("MCTS strength against alpha-beta at equal time", "[.benchmark][mcts]")
+{
+	constexpr int games = 10;
+	std::mt19937 engine{1};
+	int mcts_wins = 0;
+	int alpha_beta_wins = 0;
+	for (int game = 0; game < games; ++game)
+	{
+		flit::GameState state = flit::random_start(engine);
+		flit::bots::AlphaBetaBot alpha_beta;
+		flit::bots::MctsBot mcts;
+		flit::Cell mcts_color = game % 2 == 0 ? flit::Cell::Green : flit::Cell::Purple;
+		for (int ply = 0; ply < 1000 and state.winner() == flit::Cell::Empty; ++ply)
+		{
+			if (state.turn() == mcts_color)
+			{
+				state.commit(mcts.choose_move(state));
+			}
+			else
+			{
+				auto begin = std::chrono::steady_clock::now();
+				state.commit(alpha_beta.choose_move(state));
+				auto alpha_beta_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+					std::chrono::steady_clock::now() - begin);
+				// Give MCTS the time alpha-beta just took
+				mcts.time(std::max(alpha_beta_time, std::chrono::milliseconds{1}));
+			}
+			state.maybe_spawn_blue(engine);
+		}
+		mcts_wins += state.winner() == mcts_color;
+		alpha_beta_wins += state.winner() == flit::opponent(mcts_color);
+	}
+	WARN("MCTS " << mcts_wins << " - " << alpha_beta_wins << " alpha-beta over " << games << " games");
+}
\ No newline at end of file
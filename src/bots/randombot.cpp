@@ -1,8 +1,6 @@
 module;
 
 #include <random>
-#include <ranges>
-#include <vector>
 
 export module flit.bots.randombot;
 
@@ -14,12 +12,7 @@ namespace flit::bots
 export class RandomBot : public Bot
 {
   public:
-	Move choose_move(GameState game) override
-	{
-		std::vector<Move> moves = game.get_legal_moves() | std::ranges::to<std::vector>();
-		std::uniform_int_distribution<std::size_t> dist{0, moves.size() - 1};
-		return moves[dist(engine)];
-	}
+	Move choose_move(GameState game) override { return *game.random_legal_move(engine); }
 
   private:
 	std::mt19937 engine{};
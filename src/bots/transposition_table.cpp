@@ -0,0 +1,262 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+export module flit.transposition_table;
+
+import flit.huge_pages;
+import flit.mapped_file;
+
+namespace flit
+{
+
+export enum class TranspositionBound : std::uint8_t {
+	Exact,
+	LowerBound,
+	UpperBound,
+};
+
+export struct TranspositionData
+{
+	int score;
+	int depth;
+	TranspositionBound bound;
+	/// Cells of the best move found, equal when there is none
+	std::uint16_t best_from = 0;
+	std::uint16_t best_to = 0;
+};
+
+export constexpr std::array<char, 4> transposition_table_magic{'F', 'L', 'T', 'T'};
+export constexpr std::uint32_t transposition_table_version = 3;
+
+namespace
+{
+
+/// A key and its data, stored as the data and the key xor the data. Both words are written without a lock, so
+/// an entry torn by a concurrent write or a process that died mid-store fails verification and reads as a miss.
+struct alignas(16) Entry
+{
+	std::uint64_t check;
+	std::uint64_t data;
+};
+
+/// Start of a shared segment, one cache line so the entries after it stay aligned
+struct alignas(64) SharedHeader
+{
+	/// Magic and version, set once by the first process to open the segment
+	std::uint64_t format;
+	/// Number of entries after the header
+	std::uint64_t size;
+	/// Static evaluation whose scores the entries hold, set once by the first process to open the segment
+	std::uint64_t evaluator;
+};
+
+constexpr std::uint64_t shared_format = []
+{
+	std::array<char, 8> format{};
+	std::ranges::copy(transposition_table_magic, format.begin());
+	for (std::size_t i = 0; i < 4; ++i)
+	{
+		format[4 + i] = static_cast<char>(transposition_table_version >> (8 * i));
+	}
+	return std::bit_cast<std::uint64_t>(format);
+}();
+
+/// The data word of an entry: a 24-bit score, an 8-bit depth, the bound plus one in two bits, so that the word of a
+/// used entry is never zero, and two 12-bit cells of the best move. Depths are clamped to the byte: below zero the
+/// search goes straight to the horizon as at zero, and above it an entry only counts for less than it could.
+constexpr std::uint64_t
+pack(TranspositionData data)
+{
+	return (std::uint64_t{static_cast<std::uint32_t>(data.score)} & 0xff'ffff)
+		| std::uint64_t{static_cast<std::uint8_t>(std::clamp(data.depth, 0, 255))} << 24
+		| std::uint64_t{std::to_underlying(data.bound) + 1u} << 32
+		| (std::uint64_t{data.best_from} & 0xfff) << 34
+		| (std::uint64_t{data.best_to} & 0xfff) << 46;
+}
+
+constexpr TranspositionData
+unpack(std::uint64_t data)
+{
+	return {
+		// Sign-extend the score
+		.score = static_cast<std::int32_t>(static_cast<std::uint32_t>(data << 8)) >> 8,
+		.depth = static_cast<std::uint8_t>(data >> 24),
+		.bound = static_cast<TranspositionBound>(((data >> 32) & 0b11) - 1),
+		.best_from = static_cast<std::uint16_t>((data >> 34) & 0xfff),
+		.best_to = static_cast<std::uint16_t>((data >> 46) & 0xfff),
+	};
+}
+
+static_assert(unpack(pack({.score = -100000, .depth = 64, .bound = TranspositionBound::UpperBound})).score == -100000);
+
+/// Claims a header word for this process's value, or checks that another process claimed it with the same value
+bool
+claim(std::uint64_t &word, std::uint64_t value)
+{
+	std::uint64_t expected = 0;
+	std::atomic_ref{word}.compare_exchange_strong(expected, value);
+	return expected == 0 or expected == value;
+}
+
+} // namespace
+
+/// Always-replace hash table of search results, either private to the solver or in shared memory
+export class TranspositionTable
+{
+  public:
+	/// A private table on huge pages
+	explicit TranspositionTable(std::size_t size) : _private{std::max<std::size_t>(1, size)}
+	{
+		_entries = &_private[0];
+		_size = _private.size();
+	}
+
+	/// A table in the named shared memory segment, created with `size` entries by the first process to open it.
+	/// Processes that open it later use the existing table whatever its size, but only with the same nonzero
+	/// `evaluator`, which identifies the static evaluation the scores come from.
+	static TranspositionTable shared(std::string const &name, std::size_t size, std::uint64_t evaluator)
+	{
+		MappedFile file = MappedFile::shared_memory(name, sizeof(SharedHeader) + std::max<std::size_t>(1, size) * sizeof(Entry));
+		auto bytes = file.writable_bytes();
+		if (bytes.size() < sizeof(SharedHeader))
+		{
+			throw std::runtime_error{"Shared transposition table is truncated"};
+		}
+		auto *header = reinterpret_cast<SharedHeader *>(bytes.data());
+		if (not claim(header->format, shared_format))
+		{
+			throw std::runtime_error{"Shared transposition table has an incompatible format"};
+		}
+		if (not claim(header->evaluator, evaluator))
+		{
+			throw std::runtime_error{"Shared transposition table holds the scores of another evaluator"};
+		}
+		std::size_t const available = (bytes.size() - sizeof(SharedHeader)) / sizeof(Entry);
+		claim(header->size, available);
+		std::size_t const entries = std::atomic_ref{header->size}.load();
+		if (entries == 0 or entries > available)
+		{
+			throw std::runtime_error{"Shared transposition table is truncated"};
+		}
+		return TranspositionTable{std::make_shared<MappedFile>(std::move(file)), entries};
+	}
+
+	/// Another handle on this shared table, so that the solvers of one process open the segment once
+	TranspositionTable share() const
+	{
+		if (not _shared)
+		{
+			throw std::runtime_error{"Only a shared transposition table can be shared"};
+		}
+		return TranspositionTable{_shared, _size};
+	}
+
+	/// The number of entries that fit in the given number of megabytes
+	static constexpr std::size_t entries(std::size_t megabytes)
+	{
+		return std::max<std::size_t>(1, (megabytes << 20) / sizeof(Entry));
+	}
+
+	std::optional<TranspositionData> probe(std::uint64_t key) const
+	{
+		Entry &entry = _entries[key % _size];
+		std::uint64_t const data = std::atomic_ref{entry.data}.load(std::memory_order_relaxed);
+		std::uint64_t const check = std::atomic_ref{entry.check}.load(std::memory_order_relaxed);
+		if (data == 0 or (check ^ data) != key)
+		{
+			return std::nullopt;
+		}
+		return unpack(data);
+	}
+
+	/// Starts loading the entry of a key into the cache, so a later probe or store does not wait on memory
+	void prefetch(std::uint64_t key) const
+	{
+#if defined(__GNUC__)
+		__builtin_prefetch(&_entries[key % _size]);
+#endif
+	}
+
+	void store(std::uint64_t key, TranspositionData data)
+	{
+		Entry &entry = _entries[key % _size];
+		std::uint64_t const packed = pack(data);
+		std::atomic_ref{entry.check}.store(key ^ packed, std::memory_order_relaxed);
+		std::atomic_ref{entry.data}.store(packed, std::memory_order_relaxed);
+	}
+
+	/// Empties a private table, mapping fresh pages rather than writing to the old ones. A shared table is kept, as
+	/// other processes use it and it only ever holds the scores of one evaluator.
+	void clear()
+	{
+		if (not _shared)
+		{
+			_private = HugePageArray<Entry>{_size};
+			_entries = &_private[0];
+		}
+	}
+
+	std::size_t size() const { return _size; }
+	bool is_shared() const { return _shared != nullptr; }
+	PageKind page_kind() const { return _shared ? PageKind::Shared : _private.page_kind(); }
+
+  private:
+	TranspositionTable(std::shared_ptr<MappedFile> file, std::size_t size) : _shared{std::move(file)}, _size{size}
+	{
+		_entries = reinterpret_cast<Entry *>(_shared->writable_bytes().data() + sizeof(SharedHeader));
+	}
+
+	HugePageArray<Entry> _private;
+	std::shared_ptr<MappedFile> _shared;
+	Entry *_entries = nullptr;
+	std::size_t _size = 0;
+};
+
+/// Always-replace direct-mapped cache of static evaluations, private to one solver. Kept apart from the
+/// transposition table so the far more numerous leaves do not evict the results of deep searches.
+export class EvaluationCache
+{
+  public:
+	/// A cache of at least `size` entries, rounded up to a power of two
+	explicit EvaluationCache(std::size_t size) : _entries{std::bit_ceil(std::max<std::size_t>(1, size))} {}
+
+	std::optional<int> probe(std::uint64_t key) const
+	{
+		Slot const &slot = _entries[key & (_entries.size() - 1)];
+		if (slot.check != check(key))
+		{
+			return std::nullopt;
+		}
+		return slot.score;
+	}
+
+	void store(std::uint64_t key, int score) { _entries[key & (_entries.size() - 1)] = {check(key), score}; }
+
+	std::size_t size() const { return _entries.size(); }
+
+  private:
+	/// The high half of the key, which the index does not use, with the lowest bit set so that it never matches an
+	/// unused slot
+	struct Slot
+	{
+		std::uint32_t check;
+		std::int32_t score;
+	};
+
+	static constexpr std::uint32_t check(std::uint64_t key) { return static_cast<std::uint32_t>(key >> 32) | 1; }
+
+	HugePageArray<Slot> _entries;
+};
+
+} // namespace flit
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include <catch2/catch_test_macros.hpp>
+#include <libassert/assert-catch2.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+import flit.huge_pages;
+import flit.mapped_file;
+import flit.transposition_table;
+
+namespace
+{
+
+/// Identity of the evaluator filling the shared tables of the tests
+constexpr std::uint64_t evaluator = 0x5eed;
+
+std::string
+segment_name(std::string_view test)
+{
+	return std::format("/flit-test-{}-{}", test, ::getpid());
+}
+
+} // namespace
+
+TEST_CASE("Transposition entries only match their own key", "[transposition_table]")
+{
+	flit::TranspositionTable table{1024};
+	ASSERT(not table.probe(42).has_value());
+
+	table.store(42, {.score = -1234, .depth = 3, .bound = flit::TranspositionBound::LowerBound});
+	auto entry = table.probe(42);
+	ASSERT(entry.has_value());
+	ASSERT(entry->score == -1234);
+	ASSERT(entry->depth == 3);
+	ASSERT(entry->bound == flit::TranspositionBound::LowerBound);
+
+	table.store(43, {.score = 100000, .depth = 64, .bound = flit::TranspositionBound::Exact, .best_from = 399, .best_to = 0});
+	entry = table.probe(43);
+	ASSERT(entry.has_value());
+	ASSERT(entry->score == 100000);
+	ASSERT(entry->depth == 64);
+	ASSERT(entry->best_from == 399);
+	ASSERT(entry->best_to == 0);
+
+	// Same slot, different key
+	ASSERT(not table.probe(42 + table.size()).has_value());
+	ASSERT(not table.probe(0).has_value());
+}
+
+TEST_CASE("Transposition entry depths are clamped to what they can hold", "[transposition_table]")
+{
+	flit::TranspositionTable table{1024};
+	table.store(1, {.score = 5, .depth = -1, .bound = flit::TranspositionBound::UpperBound});
+	ASSERT(table.probe(1)->depth == 0);
+	ASSERT(table.probe(1)->score == 5);
+	table.store(2, {.score = -5, .depth = 300, .bound = flit::TranspositionBound::LowerBound});
+	ASSERT(table.probe(2)->depth == 255);
+	ASSERT(table.probe(2)->score == -5);
+	ASSERT(table.probe(2)->bound == flit::TranspositionBound::LowerBound);
+}
+
+TEST_CASE("Shared transposition tables are seen by every handle", "[transposition_table]")
+{
+	std::string const name = segment_name("shared");
+	flit::MappedFile::unlink_shared_memory(name);
+	{
+		flit::TranspositionTable first = flit::TranspositionTable::shared(name, 1024, evaluator);
+		ASSERT(first.is_shared());
+		ASSERT(first.page_kind() == flit::PageKind::Shared);
+		ASSERT(first.size() == 1024);
+		first.store(7, {.score = 99, .depth = 2, .bound = flit::TranspositionBound::Exact});
+
+		// A later process uses the existing table whatever size it asks for
+		flit::TranspositionTable second = flit::TranspositionTable::shared(name, 4096, evaluator);
+		ASSERT(second.size() == 1024);
+		auto entry = second.probe(7);
+		ASSERT(entry.has_value());
+		ASSERT(entry->score == 99);
+
+		// Solvers of one process share the mapping
+		flit::TranspositionTable third = second.share();
+		ASSERT(third.is_shared());
+		ASSERT(third.size() == 1024);
+		third.store(8, {.score = 42, .depth = 1, .bound = flit::TranspositionBound::LowerBound});
+		ASSERT(first.probe(8).has_value());
+	}
+	REQUIRE_THROWS_AS(flit::TranspositionTable{1024}.share(), std::runtime_error);
+	ASSERT(flit::TranspositionTable{1024}.page_kind() != flit::PageKind::Shared);
+	// The table outlives its users
+	flit::TranspositionTable reopened = flit::TranspositionTable::shared(name, 1024, evaluator);
+	ASSERT(reopened.probe(7).has_value());
+	flit::MappedFile::unlink_shared_memory(name);
+}
+
+TEST_CASE("Shared segments are sized only by their creator", "[transposition_table]")
+{
+	std::string const name = segment_name("size");
+	flit::MappedFile::unlink_shared_memory(name);
+	flit::MappedFile larger = flit::MappedFile::shared_memory(name, 8192);
+	flit::MappedFile smaller = flit::MappedFile::shared_memory(name, 4096);
+	ASSERT(smaller.bytes().size() == 8192);
+	// Would fault had the segment been truncated under the first mapping
+	larger.writable_bytes()[8191] = std::byte{1};
+	ASSERT(smaller.bytes()[8191] == std::byte{1});
+	flit::MappedFile::unlink_shared_memory(name);
+}
+
+TEST_CASE("Shared segments left unsized by a dead creator are taken over", "[transposition_table]")
+{
+	std::string const name = segment_name("unsized");
+	flit::MappedFile::unlink_shared_memory(name);
+	// As left by a process that died between creating the segment and sizing it
+	int const fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	REQUIRE(fd >= 0);
+	::close(fd);
+
+	flit::MappedFile segment = flit::MappedFile::shared_memory(name, 4096);
+	ASSERT(segment.bytes().size() == 4096);
+	flit::MappedFile::unlink_shared_memory(name);
+}
+
+TEST_CASE("Shared segments of another format or evaluator are rejected", "[transposition_table]")
+{
+	std::string const name = segment_name("format");
+	flit::MappedFile::unlink_shared_memory(name);
+	{
+		flit::MappedFile segment = flit::MappedFile::shared_memory(name, 4096);
+		segment.writable_bytes()[0] = std::byte{'X'};
+	}
+	REQUIRE_THROWS_AS(flit::TranspositionTable::shared(name, 1024, evaluator), std::runtime_error);
+	flit::MappedFile::unlink_shared_memory(name);
+
+	// Scores of different evaluators do not mix
+	flit::TranspositionTable table = flit::TranspositionTable::shared(name, 1024, evaluator);
+	REQUIRE_THROWS_AS(flit::TranspositionTable::shared(name, 1024, evaluator + 2), std::runtime_error);
+	flit::MappedFile::unlink_shared_memory(name);
+}
+
+TEST_CASE("Evaluation cache entries only match their own key", "[transposition_table]")
+{
+	flit::EvaluationCache cache{1000};
+	ASSERT(cache.size() == 1024);
+	ASSERT(not cache.probe(0).has_value());
+	ASSERT(not cache.probe(42).has_value());
+
+	cache.store(42, -1234);
+	ASSERT(cache.probe(42) == -1234);
+	// Same slot, different key
+	ASSERT(not cache.probe(42 + (std::uint64_t{1} << 40)).has_value());
+
+	// Always replaced
+	cache.store(42 + (std::uint64_t{1} << 41), 5);
+	ASSERT(cache.probe(42 + (std::uint64_t{1} << 41)) == 5);
+	ASSERT(not cache.probe(42).has_value());
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+module;
+
+#include <charconv>
+#include <concepts>
+#include <format>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+export module flit.cli;
+
+namespace flit
+{
+
+/// Command line options of the form `--name value` or `--flag`
+export class Arguments
+{
+  public:
+	Arguments(int argc, char const *const *argv)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string_view arg = argv[i];
+			if (not arg.starts_with("--"))
+			{
+				throw std::runtime_error{std::format("Unexpected argument '{}'", arg)};
+			}
+			std::string_view value;
+			if (i + 1 < argc and not std::string_view{argv[i + 1]}.starts_with("--"))
+			{
+				value = argv[++i];
+			}
+			_options.emplace(arg.substr(2), value);
+		}
+	}
+
+	bool empty() const { return _options.empty(); }
+
+	bool has(std::string_view name) const { return _options.contains(name); }
+
+	std::string_view get(std::string_view name) const
+	{
+		if (auto iter = _options.find(name); iter != _options.end())
+		{
+			return iter->second;
+		}
+		else
+		{
+			throw std::runtime_error{std::format("Missing option --{}", name)};
+		}
+	}
+
+	std::string_view get(std::string_view name, std::string_view fallback) const
+	{
+		return has(name) ? get(name) : fallback;
+	}
+
+	template <typename T>
+		requires std::integral<T> or std::floating_point<T>
+	T get(std::string_view name, T fallback) const
+	{
+		if (not has(name))
+		{
+			return fallback;
+		}
+		std::string_view text = get(name);
+		T value;
+		auto [ptr, errc] = std::from_chars(text.data(), text.data() + text.size(), value);
+		if (errc != std::errc{} or ptr != text.data() + text.size())
+		{
+			throw std::runtime_error{std::format("Invalid value for --{}", name)};
+		}
+		return value;
+	}
+
+  private:
+	std::map<std::string, std::string, std::less<>> _options;
+};
+
+} // namespace flit
\ No newline at end of file
@@ -0,0 +1,459 @@
+module;
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <sstream>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+export module flit.engine;
+
+import flit.game;
+import flit.evaluator;
+
+namespace flit
+{
+
+namespace
+{
+
+/// Depth searched by `go` without a depth, in practice until stopped
+constexpr int max_depth = 64;
+
+/// A cell in the notation of moves, e.g. `E5` for row 5 of column E
+GameState::Index
+parse_cell(std::string_view text)
+{
+	if (text.size() >= 2 and text[0] >= 'A' and text[0] < 'A' + cols)
+	{
+		int row = 0;
+		auto [ptr, errc] = std::from_chars(text.data() + 1, text.data() + text.size(), row);
+		if (errc == std::errc{} and ptr == text.data() + text.size() and row >= 1 and row <= rows)
+		{
+			return from_rc(row - 1, text[0] - 'A');
+		}
+	}
+	throw std::runtime_error{std::format("Invalid cell '{}'", text)};
+}
+
+/// A position in the notation `<cells> <green|purple>`, where the cells are `.GPB` in row-major order, or `empty`
+GameState
+parse_position(std::istringstream &words)
+{
+	std::string cells;
+	std::string turn;
+	words >> cells >> turn;
+	GameState state;
+	if (cells != "empty")
+	{
+		std::erase(cells, '/');
+		if (cells.size() != GameState::num_cells)
+		{
+			throw std::runtime_error{std::format("Expected {} cells", GameState::num_cells)};
+		}
+		for (std::size_t idx = 0; idx < cells.size(); ++idx)
+		{
+			switch (cells[idx])
+			{
+			case '.': break;
+			case 'G': state.set(idx, Cell::Green); break;
+			case 'P': state.set(idx, Cell::Purple); break;
+			case 'B': state.set(idx, Cell::Blue); break;
+			default: throw std::runtime_error{std::format("Invalid cell '{}'", cells[idx])};
+			}
+		}
+	}
+	if (turn == "green")
+	{
+		state.turn(Cell::Green);
+	}
+	else if (turn == "purple")
+	{
+		state.turn(Cell::Purple);
+	}
+	else
+	{
+		throw std::runtime_error{"Expected the player to move"};
+	}
+	return state;
+}
+
+} // namespace
+
+/// A long-lived engine speaking a line protocol modelled on UCI. Searches run on a background thread, which streams
+/// `info` lines and ends with `bestmove`, while further commands such as `stop` are read. The thread and the
+/// transposition table stay warm between searches.
+export class Engine
+{
+  public:
+	explicit Engine(std::ostream &out) : _out{out}
+	{
+		_search = std::jthread{[this](std::stop_token token) { run_searches(token); }};
+	}
+
+	Engine(Engine const &) = delete;
+	Engine &operator=(Engine const &) = delete;
+
+	~Engine() { halt(); }
+
+	/// Handles one command, reporting errors as `info string` lines. Returns false once the engine should quit.
+	bool interpret(std::string_view line)
+	{
+		std::istringstream words{std::string{line}};
+		std::string command;
+		words >> command;
+		try
+		{
+			if (command == "uci")
+			{
+				uci();
+			}
+			else if (command == "isready")
+			{
+				send("readyok");
+			}
+			else if (command == "newgame")
+			{
+				halt();
+				_solver.reset();
+			}
+			else if (command == "setoption")
+			{
+				setoption(words);
+			}
+			else if (command == "position")
+			{
+				position(words);
+			}
+			else if (command == "go")
+			{
+				go(words);
+			}
+			else if (command == "stop")
+			{
+				_stop.request_stop();
+			}
+			else if (command == "ponderhit")
+			{
+				ponderhit();
+			}
+			else if (command == "quit")
+			{
+				halt();
+				return false;
+			}
+			else if (not command.empty())
+			{
+				throw std::runtime_error{std::format("Unknown command '{}'", command)};
+			}
+		}
+		catch (std::exception &ex)
+		{
+			send("info string {}", ex.what());
+		}
+		return true;
+	}
+
+	/// Waits for the running search, if any, to finish on its own
+	void wait()
+	{
+		std::unique_lock lock{_search_mutex};
+		_search_changed.wait(lock, [&] { return not _searching; });
+	}
+
+  private:
+	void uci()
+	{
+		SearchOptions defaults;
+		send("id name FlitSolver");
+		send("option name hash type spin default {} min 1", _hash_megabytes);
+		send("option name quiescence type check default {}", defaults.quiescence);
+		send("option name lmr type check default {}", defaults.late_move_reductions);
+		send("option name lmr-moves type spin default {}", defaults.reduction_move_count);
+		send("option name lmr-depth type spin default {}", defaults.reduction_min_depth);
+		send("option name futility type check default {}", defaults.futility_pruning);
+		send("option name futility-margin type spin default {}", defaults.futility_margin);
+		send("option name max-sources type spin default {}", defaults.max_sources);
+		send("option name multipv type spin default {} min 1", defaults.multipv);
+		send("option name repetition-score type spin default {}", defaults.repetition_score);
+		send("uciok");
+	}
+
+	/// `setoption name <name> value <value>`
+	void setoption(std::istringstream &words)
+	{
+		std::string keyword;
+		std::string name;
+		std::string value_keyword;
+		int value = 0;
+		if (not(words >> keyword >> name >> value_keyword >> value) or keyword != "name" or value_keyword != "value")
+		{
+			throw std::runtime_error{"Expected setoption name <name> value <value>"};
+		}
+		halt();
+		if (name == "hash")
+		{
+			if (value <= 0)
+			{
+				throw std::runtime_error{"Invalid value"};
+			}
+			_hash_megabytes = value;
+			_solver.reset();
+		}
+		else if (not set_search_option(_options, name, value))
+		{
+			throw std::runtime_error{std::format("Unknown option '{}'", name)};
+		}
+	}
+
+	/// `position <cells|empty> <green|purple> [moves <move>...]`, where a move is e.g. `E5-E7`, or `+C3` for a blue
+	/// spawned on C3
+	void position(std::istringstream &words)
+	{
+		GameState state = parse_position(words);
+		std::string word;
+		if (words >> word and word != "moves")
+		{
+			throw std::runtime_error{"Expected moves"};
+		}
+		while (words >> word)
+		{
+			if (word.starts_with('+'))
+			{
+				auto idx = parse_cell(std::string_view{word}.substr(1));
+				if (state.get(idx) != Cell::Empty)
+				{
+					throw std::runtime_error{std::format("Cannot spawn on '{}'", word)};
+				}
+				state.set(idx, Cell::Blue);
+				continue;
+			}
+			auto dash = word.find('-');
+			if (dash == std::string::npos)
+			{
+				throw std::runtime_error{std::format("Invalid move '{}'", word)};
+			}
+			auto from = parse_cell(std::string_view{word}.substr(0, dash));
+			auto to = parse_cell(std::string_view{word}.substr(dash + 1));
+			std::optional<Move> legal;
+			for (Move move : state.get_legal_moves())
+			{
+				if (move.from == from and move.to == to)
+				{
+					legal = move;
+					break;
+				}
+			}
+			if (not legal)
+			{
+				throw std::runtime_error{std::format("Illegal move '{}'", word)};
+			}
+			state.commit(*legal);
+		}
+		halt();
+		_state = state;
+	}
+
+	/// `go [depth <plies>] [movetime <ms>] [infinite] [ponder]`. A pondering search starts its clock on `ponderhit`.
+	void go(std::istringstream &words)
+	{
+		int depth = max_depth;
+		std::optional<std::chrono::milliseconds> move_time;
+		bool ponder = false;
+		auto read_int = [&](std::string const &name)
+		{
+			int value;
+			if (not(words >> value) or value < 0)
+			{
+				throw std::runtime_error{std::format("Invalid value for {}", name)};
+			}
+			return value;
+		};
+		std::string word;
+		while (words >> word)
+		{
+			if (word == "depth")
+			{
+				depth = read_int(word);
+			}
+			else if (word == "movetime")
+			{
+				move_time = std::chrono::milliseconds{read_int(word)};
+			}
+			else if (word == "ponder")
+			{
+				ponder = true;
+			}
+			else if (word != "infinite")
+			{
+				throw std::runtime_error{std::format("Invalid go argument '{}'", word)};
+			}
+		}
+		if (_state.turn() != Cell::Green and _state.turn() != Cell::Purple)
+		{
+			throw std::runtime_error{"No position"};
+		}
+
+		halt();
+		if (not _solver)
+		{
+			_solver.emplace(GameState{}, Solver::transposition_table_entries(_hash_megabytes), _options);
+		}
+		_solver->reset(_state);
+		_solver->options(_options);
+		_stop = {};
+		_ponder_time = ponder ? move_time : std::nullopt;
+		if (move_time and not ponder)
+		{
+			start_timer(*move_time);
+		}
+		std::function<void()> search{
+			[this, depth, stop = _stop.get_token(), begin = std::chrono::steady_clock::now()]
+			{
+				auto report = [&](int iteration, std::vector<solve_result> const &results)
+				{
+					auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin);
+					for (std::size_t i = 0; i < std::min<std::size_t>(_options.multipv, results.size()); ++i)
+					{
+						std::string line;
+						for (Move move : _solver->principal_variation(results[i].move, iteration + 1))
+						{
+							std::format_to(std::back_inserter(line), " {}", move);
+						}
+						send(
+							"info depth {} multipv {} score {} nodes {} time {} pv{}",
+							iteration,
+							i + 1,
+							results[i].score,
+							_solver->stats().nodes,
+							elapsed.count(),
+							line);
+					}
+				};
+				auto results = _solver->solve(_state.turn(), depth, stop, report);
+				if (results.empty())
+				{
+					send("bestmove none");
+				}
+				else
+				{
+					send("bestmove {}", results[0].move);
+				}
+			}};
+		{
+			std::lock_guard lock{_search_mutex};
+			_pending = std::move(search);
+			_searching = true;
+		}
+		_search_changed.notify_all();
+	}
+
+	/// Runs the searches handed over by `go`, one at a time, until the engine is destroyed
+	void run_searches(std::stop_token token)
+	{
+		std::unique_lock lock{_search_mutex};
+		while (_search_changed.wait(lock, token, [&] { return static_cast<bool>(_pending); }))
+		{
+			std::function<void()> search = std::exchange(_pending, nullptr);
+			lock.unlock();
+			search();
+			lock.lock();
+			_searching = false;
+			_search_changed.notify_all();
+		}
+	}
+
+	void ponderhit()
+	{
+		if (_ponder_time)
+		{
+			start_timer(*_ponder_time);
+			_ponder_time.reset();
+		}
+	}
+
+	/// Stops the search once the time is up, unless it ends or the timer is replaced first
+	void start_timer(std::chrono::milliseconds time)
+	{
+		_timer = std::jthread{
+			[deadline = std::chrono::steady_clock::now() + time, search = _stop](std::stop_token token) mutable
+			{
+				std::mutex mutex;
+				std::condition_variable_any expired;
+				std::unique_lock lock{mutex};
+				if (not expired.wait_until(lock, token, deadline, [] { return false; }) and not token.stop_requested())
+				{
+					search.request_stop();
+				}
+			}};
+	}
+
+	/// Stops the running search, if any, and waits for it
+	void halt()
+	{
+		_stop.request_stop();
+		wait();
+		_timer = {};
+	}
+
+	template <typename... Args>
+	void send(std::format_string<Args...> format, Args &&...args)
+	{
+		std::scoped_lock lock{_out_mutex};
+		std::println(_out, format, std::forward<Args>(args)...);
+		_out.flush();
+	}
+
+	std::ostream &_out;
+	std::mutex _out_mutex;
+	GameState _state;
+	SearchOptions _options;
+	std::size_t _hash_megabytes = 256;
+	std::optional<Solver> _solver;
+	std::optional<std::chrono::milliseconds> _ponder_time;
+	std::stop_source _stop;
+	std::jthread _timer;
+	std::mutex _search_mutex;
+	std::condition_variable_any _search_changed;
+	/// The search `go` handed over, until the search thread takes it
+	std::function<void()> _pending;
+	/// Whether a search was handed over and has not finished yet
+	bool _searching = false;
+	/// Declared last, so that it is stopped and joined before the state it searches is destroyed
+	std::jthread _search;
+};
+
+/// Runs the engine on standard input and output until `quit` or the end of the input. Either stops the running search,
+/// as nothing could stop an infinite one once the input is gone.
+export void
+engine()
+{
+	Engine engine{std::cout};
+	std::string line;
+	while (std::getline(std::cin, line))
+	{
+		if (not engine.interpret(line))
+		{
+			return;
+		}
+	}
+	// The engine halts the search on destruction, like `quit`
+}
+
+} // namespace flit
\ No newline at end of file
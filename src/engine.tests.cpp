@@ -0,0 +1,129 @@
+#include <catch2/catch_test_macros.hpp>
+#include <libassert/assert-catch2.hpp>
+
+#include <format>
+#include <sstream>
+#include <string>
+
+import flit.engine;
+import flit.game;
+
+namespace
+{
+
+constexpr char capture_position[] = "position "
+									"............"
+									"............"
+									"............"
+									"............"
+									".....G......"
+									".....G......"
+									"............"
+									".....B......"
+									"............"
+									"............"
+									"............"
+									"PP.........."
+									" green";
+
+} // namespace
+
+TEST_CASE("Engine streams iterations and the best move", "[engine]")
+{
+	std::ostringstream out;
+	{
+		flit::Engine engine{out};
+		engine.interpret("setoption name hash value 16");
+		engine.interpret(capture_position);
+		engine.interpret("go depth 2");
+		engine.wait();
+	}
+	std::string output = out.str();
+	INFO(output);
+	ASSERT(output.find("info depth 0 ") != std::string::npos);
+	ASSERT(output.find("info depth 2 ") != std::string::npos);
+	ASSERT(output.find("info depth 3 ") == std::string::npos);
+	// The best move starts the principal variation of the deepest iteration and brings the back piece up to the blue
+	auto pv = output.rfind(" pv ");
+	ASSERT(pv != std::string::npos);
+	std::string best = output.substr(pv + 4, output.find_first_of(" \n", pv + 4) - pv - 4);
+	ASSERT(output.find("bestmove " + best + "\n") != std::string::npos);
+	ASSERT(best.starts_with("F5-"));
+}
+
+TEST_CASE("Engine runs one search after another", "[engine]")
+{
+	std::ostringstream out;
+	{
+		flit::Engine engine{out};
+		engine.interpret("setoption name hash value 16");
+		engine.interpret(capture_position);
+		for (int i = 0; i < 3; ++i)
+		{
+			engine.interpret("go depth 1");
+			engine.wait();
+		}
+		// Replaces a search still running
+		engine.interpret("go infinite");
+		engine.interpret("go depth 0");
+	}
+	std::string output = out.str();
+	INFO(output);
+	int searches = 0;
+	for (auto pos = output.find("bestmove "); pos != std::string::npos; pos = output.find("bestmove ", pos + 1))
+	{
+		++searches;
+	}
+	ASSERT(searches == 5);
+}
+
+TEST_CASE("Engine stops infinite searches", "[engine]")
+{
+	std::ostringstream out;
+	{
+		flit::Engine engine{out};
+		engine.interpret("setoption name hash value 16");
+		engine.interpret(capture_position);
+		engine.interpret("go infinite");
+		engine.interpret("stop");
+		engine.wait();
+	}
+	std::string output = out.str();
+	INFO(output);
+	// The first iteration always completes, and its best move is played
+	auto const bestmove = output.find("bestmove ");
+	ASSERT(output.find("info depth 0 ") < bestmove);
+	std::string const best = output.substr(bestmove + 9, output.find('\n', bestmove) - bestmove - 9);
+
+	flit::GameState state{};
+	state.set(4, 5, flit::Cell::Green);
+	state.set(5, 5, flit::Cell::Green);
+	state.set(7, 5, flit::Cell::Blue);
+	state.set(11, 0, flit::Cell::Purple);
+	state.set(11, 1, flit::Cell::Purple);
+	state.turn(flit::Cell::Green);
+	bool legal = false;
+	for (flit::Move move : state.get_legal_moves())
+	{
+		legal = legal or std::format("{}", move) == best;
+	}
+	ASSERT(legal);
+}
+
+TEST_CASE("Engine applies moves and reports errors", "[engine]")
+{
+	std::ostringstream out;
+	flit::Engine engine{out};
+	engine.interpret("position empty green moves A1-A2");
+	engine.interpret("position empty green moves A99999999999999999999-A2");
+	engine.interpret("position empty green moves A1x-A2");
+	engine.interpret(std::string{capture_position} + " moves F5-F7 +A6 B12-A11");
+	engine.interpret("isready");
+	std::string output = out.str();
+	INFO(output);
+	ASSERT(output.find("info string Illegal move 'A1-A2'\n") != std::string::npos);
+	ASSERT(output.find("info string Invalid cell 'A99999999999999999999'\n") != std::string::npos);
+	ASSERT(output.find("info string Invalid cell 'A1x'\n") != std::string::npos);
+	ASSERT(output.find("info string", output.find("A1x")) == std::string::npos);
+	ASSERT(output.ends_with("readyok\n"));
+}
\ No newline at end of file
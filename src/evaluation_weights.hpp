@@ -0,0 +1,13 @@
+#pragma once
+
+// Generated by the tuner. Weights of the evaluation features, in order:
+// material, mobility, capture targets, isolated pieces
+
+#include <array>
+
+namespace flit
+{
+
+inline constexpr std::array<int, 4> evaluation_weights{1000, 0, 0, 0};
+
+} // namespace flit
@@ -4,46 +4,94 @@ module;
 
 #include <algorithm>
 #include <array>
+#include <bitset>
 #include <cstddef>
 #include <cstdint>
 #include <format>
-#include <functional>
 #include <generator>
+#include <limits>
+#include <optional>
 #include <random>
 #include <ranges>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "evaluation_weights.hpp"
 
 export module flit.game;
 
 namespace flit
 {
 
-export constexpr std::uint_fast8_t rows = 12;
-export constexpr std::uint_fast8_t cols = 12;
-constexpr std::uint_fast8_t num_cells = rows * cols;
+#ifdef FLITSOLVER_VERIFY_STATE
+constexpr bool verify_state = true;
+#else
+constexpr bool verify_state = false;
+#endif
+
+/// A blue piece spawns after a move with a chance of one in this many
+export constexpr int blue_spawn_odds = 6;
+
+/// Terms of the evaluation function, combined using evaluation_weights
+export constexpr std::array<std::string_view, 4> feature_names{
+	"material",
+	"mobility",
+	"capture targets",
+	"isolated pieces",
+};
+export constexpr std::size_t num_features = feature_names.size();
+static_assert(evaluation_weights.size() == num_features);
 
-export constexpr std::uint_fast8_t
-from_rc(std::uint_fast8_t row, std::uint_fast8_t col) noexcept
+/// Geometry of a board of the given size, wrapping around at the edges
+export template <std::uint_fast8_t Rows, std::uint_fast8_t Cols>
+struct Board
 {
-	LIBASSERT_DEBUG_ASSERT(row < rows);
-	LIBASSERT_DEBUG_ASSERT(col < cols);
-	return row * cols + col;
-}
+	static constexpr std::uint_fast8_t rows = Rows;
+	static constexpr std::uint_fast8_t cols = Cols;
+	static constexpr std::size_t num_cells = std::size_t{Rows} * Cols;
+	/// Cell index type, as narrow as the board allows. The fast types are wider than they need to be on common targets.
+	using Index = std::conditional_t<(num_cells < 256), std::uint8_t, std::uint16_t>;
 
-export struct Move
+	static constexpr Index from_rc(std::uint_fast8_t row, std::uint_fast8_t col) noexcept
+	{
+		LIBASSERT_DEBUG_ASSERT(row < rows);
+		LIBASSERT_DEBUG_ASSERT(col < cols);
+		return row * cols + col;
+	}
+
+	/// Up, down, right and left neighbors of every cell, in the order of the blue flag bits
+	static constexpr std::array<std::array<Index, 4>, num_cells> neighbors = []
+	{
+		std::array<std::array<Index, 4>, num_cells> result{};
+		for (std::size_t idx = 0; idx < num_cells; ++idx)
+		{
+			result[idx] = {
+				static_cast<Index>((idx + num_cells - cols) % num_cells),
+				static_cast<Index>((idx + cols) % num_cells),
+				static_cast<Index>((idx + 1) % cols == 0 ? idx + 1 - cols : idx + 1),
+				static_cast<Index>(idx % cols == 0 ? idx + cols - 1 : idx - 1),
+			};
+		}
+		return result;
+	}();
+};
+
+export template <std::uint_fast8_t Rows, std::uint_fast8_t Cols>
+struct BasicMove
 {
+	using Index = Board<Rows, Cols>::Index;
+
 	/// Cell index of origin
-	std::uint_fast8_t from;
+	Index from;
 	/// Cell index of destination
-	std::uint_fast8_t to;
+	Index to;
 	// Direction of any blues that will be converted by this move
 	std::uint_fast8_t blue_flags;
 
-	friend bool operator==(Move, Move);
+	friend bool operator==(BasicMove, BasicMove) = default;
 };
 
-[[clang::always_inline]]
-bool operator==(Move, Move) = default;
-
 export enum class Cell : std::uint_fast8_t {
 	Empty = 0,
 	Green = 1,
@@ -58,264 +106,747 @@ opponent(Cell player) noexcept
 	return static_cast<Cell>(std::to_underlying(player) ^ std::uint_fast8_t{0b11});
 }
 
-namespace
+/// Move generator filters, deciding per target cell whether its moves are generated at all
+export struct AllTargets
+{
+	constexpr bool operator()(auto const &, std::size_t) const { return true; }
+};
+
+/// Targets next to a blue, so every move to them captures
+export struct CaptureTargets
 {
+	bool operator()(auto const &state, std::size_t target) const { return state.is_capture_target(target); }
+};
 
-std::array<std::uint_fast8_t, 4>
-get_neighbors(std::uint_fast8_t idx)
+/// Targets that capture nothing
+export struct QuietTargets
 {
-	LIBASSERT_DEBUG_ASSERT(idx < num_cells);
-	return {
-		static_cast<std::uint_fast8_t>((idx + num_cells - rows) % num_cells),
-		static_cast<std::uint_fast8_t>((idx + rows) % num_cells),
-		static_cast<std::uint_fast8_t>((idx + 1) - rows * !((idx + 1) % cols)),
-		static_cast<std::uint_fast8_t>((idx - 1) + rows * !(idx % cols)),
-	};
-}
+	bool operator()(auto const &state, std::size_t target) const { return not state.is_capture_target(target); }
+};
 
-} // namespace
+/// Targets inside a set of cells
+export template <std::size_t Cells>
+struct BasicRegionTargets
+{
+	std::bitset<Cells> region;
 
-std::array<std::array<std::uint_fast8_t, 4>, num_cells> const neighbors = []
+	bool operator()(auto const &, std::size_t target) const { return region.test(target); }
+};
+
+/// One step of the splitmix64 generator, usable in constant expressions
+export constexpr std::uint64_t
+splitmix64(std::uint64_t &state) noexcept
 {
-	std::remove_cv_t<decltype(neighbors)> result{};
-	std::ranges::copy(
-		std::views::iota(std::uint_fast8_t{0}, num_cells) | std::views::transform(get_neighbors), result.begin());
-	return result;
-}();
+	std::uint64_t z = (state += 0x9e37'79b9'7f4a'7c15);
+	z = (z ^ (z >> 30)) * 0xbf58'476d'1ce4'e5b9;
+	z = (z ^ (z >> 27)) * 0x94d0'49bb'1331'11eb;
+	return z ^ (z >> 31);
+}
 
-namespace
+/// A hash of the compiled-in evaluation weights, telling the heuristics of different builds apart
+export constexpr std::uint64_t evaluation_weights_hash = []
 {
+	std::uint64_t hash = 0;
+	for (int weight : evaluation_weights)
+	{
+		hash ^= static_cast<std::uint32_t>(weight);
+		hash = splitmix64(hash);
+	}
+	return hash;
+}();
 
+export template <std::size_t Cells>
 struct ZobristTable
 {
-	std::array<std::uint64_t, 3uz * num_cells> cell_table;
+	/// Keys per cell indexed by Cell, padded to four so a row is one aligned 32-byte block.
+	/// The Empty key is zero.
+	struct alignas(32) CellKeys
+	{
+		std::array<std::uint64_t, 4> keys;
+	};
+
+	std::array<CellKeys, Cells> cell_table;
 	std::uint64_t is_blue_move_hash;
 	std::uint64_t is_green_move_hash;
+
+	constexpr std::uint64_t key(std::size_t idx, Cell cell) const { return cell_table[idx].keys[std::to_underlying(cell)]; }
 };
 
-ZobristTable const zobrist_table = []
+/// Generated at compile time. The keys must never change, as hashes are persisted.
+export template <std::size_t Cells>
+constexpr ZobristTable<Cells> zobrist_table = []
 {
-	std::mt19937_64 engine{12345};
-	std::uniform_int_distribution<std::uint64_t> dist{};
-	auto random_hash = std::bind_front(dist, engine);
-	ZobristTable result;
-	std::ranges::generate(result.cell_table, random_hash);
-	result.is_blue_move_hash = random_hash();
-	result.is_green_move_hash = random_hash();
+	std::uint64_t state = 12345;
+	ZobristTable<Cells> result{};
+	for (auto &cell : result.cell_table)
+	{
+		cell.keys[0] = 0;
+		for (std::size_t i = 1; i < 4; ++i)
+		{
+			cell.keys[i] = splitmix64(state);
+		}
+	}
+	result.is_blue_move_hash = splitmix64(state);
+	result.is_green_move_hash = splitmix64(state);
 	return result;
 }();
 
-} // namespace
+export template <std::uint_fast8_t Rows, std::uint_fast8_t Cols>
+class BasicGameState;
 
-export class GameState
+export template <std::uint_fast8_t Rows, std::uint_fast8_t Cols>
+std::string
+dump(BasicGameState<Rows, Cols> const &state);
+
+/// A position on a board of the given size, with the player to move
+export template <std::uint_fast8_t Rows, std::uint_fast8_t Cols>
+class BasicGameState
 {
   public:
+	using Board = flit::Board<Rows, Cols>;
+	using Index = Board::Index;
+	using Move = BasicMove<Rows, Cols>;
+
+	static constexpr std::uint_fast8_t rows = Rows;
+	static constexpr std::uint_fast8_t cols = Cols;
+	static constexpr std::size_t num_cells = Board::num_cells;
+	/// Number of pieces a player needs to win the game
+	static constexpr int winning_count = num_cells / 3;
+
+	/// What moving a piece away from its cell costs the player, independent of where it goes
+	struct SourceEffect
+	{
+		Index source;
+		/// Neighbors of the source that only it covered, which the player no longer reaches
+		std::uint_fast8_t lost_cover;
+	};
+
 	void set(std::uint_fast8_t row, std::uint_fast8_t col, Cell cell)
 	{
-		std::uint_fast8_t idx = from_rc(row, col);
+		Index idx = Board::from_rc(row, col);
 		unset(idx);
 		set(idx, cell);
 	}
 
-	Cell get(std::uint_fast8_t row, std::uint_fast8_t col) const { return _board[from_rc(row, col)]; }
+	Cell get(std::uint_fast8_t row, std::uint_fast8_t col) const { return get(Board::from_rc(row, col)); }
+	Cell get(Index idx) const { return static_cast<Cell>(_cells[idx][0]); }
+
+	/// Number of neighbors of the cell holding a piece of the given color
+	std::uint8_t cover(Index idx, Cell color) const
+	{
+		LIBASSERT_DEBUG_ASSERT(color != Cell::Empty);
+		return _cells[idx][std::to_underlying(color)];
+	}
 
 	void commit(Move move)
 	{
-		LIBASSERT_DEBUG_ASSERT(_board[move.from] == _turn);
-		LIBASSERT_DEBUG_ASSERT(_board[move.to] == Cell::Empty);
+		LIBASSERT_DEBUG_ASSERT(get(move.from) == _turn);
+		LIBASSERT_DEBUG_ASSERT(get(move.to) == Cell::Empty);
 
-		set(move.to, _board[move.from]);
+		set(move.to, get(move.from));
 		for (int i = 0; i < 4; ++i)
 		{
 			if (move.blue_flags & (1 << i))
 			{
-				set(neighbors[move.to][i], _board[move.from]);
+				set(Board::neighbors[move.to][i], get(move.from));
 			}
 		};
 		unset(move.from);
 		_turn = opponent(_turn);
-		_hash ^= zobrist_table.is_green_move_hash;
+		_hash ^= zobrist_table<num_cells>.is_green_move_hash;
+		verify();
 	}
 
 	void uncommit(Move move)
 	{
-		LIBASSERT_DEBUG_ASSERT(_board[move.to] == opponent(_turn));
-		LIBASSERT_DEBUG_ASSERT(_board[move.from] == Cell::Empty);
+		LIBASSERT_DEBUG_ASSERT(get(move.to) == opponent(_turn));
+		LIBASSERT_DEBUG_ASSERT(get(move.from) == Cell::Empty);
 
-		set(move.from, _board[move.to]);
+		set(move.from, get(move.to));
 		for (int i = 0; i < 4; ++i)
 		{
 			if (move.blue_flags & (1 << i))
 			{
-				unset(neighbors[move.to][i]);
-				set(neighbors[move.to][i], Cell::Blue);
+				unset(Board::neighbors[move.to][i]);
+				set(Board::neighbors[move.to][i], Cell::Blue);
 			}
 		};
 		unset(move.to);
 		_turn = opponent(_turn);
-		_hash ^= zobrist_table.is_green_move_hash;
+		_hash ^= zobrist_table<num_cells>.is_green_move_hash;
+		verify();
 	}
 
-	std::generator<Move> get_legal_moves() const
+	/// The hash of the position after the move, without making it
+	std::uint64_t hash_after(Move move) const
+	{
+		auto const &table = zobrist_table<num_cells>;
+		Cell const player = get(move.from);
+		std::uint64_t hash = _hash ^ table.key(move.from, player) ^ table.key(move.to, player) ^ table.is_green_move_hash;
+		for (int i = 0; i < 4; ++i)
+		{
+			if (move.blue_flags & (1 << i))
+			{
+				auto const neighbor = Board::neighbors[move.to][i];
+				hash ^= table.key(neighbor, Cell::Blue) ^ table.key(neighbor, player);
+			}
+		}
+		return hash;
+	}
+
+	std::generator<Move> get_legal_moves() const { return moves(); }
+
+	/// The legal moves that capture at least one blue
+	std::generator<Move> get_capture_moves() const { return moves(CaptureTargets{}); }
+
+	/// The legal moves to the targets accepted by the filter. Rejected targets cost no source scan.
+	template <typename Filter = AllTargets>
+	std::generator<Move> moves(Filter filter = {}) const
 	{
 		LIBASSERT_DEBUG_ASSERT(_turn == Cell::Green or _turn == Cell::Purple);
-		std::uint8_t const *player_cover = _turn == Cell::Green ? _green_cover : _purple_cover;
 
-		for (std::uint_fast8_t target = 0; target < num_cells; ++target)
+		for (Index target = 0; target < num_cells; ++target)
 		{
-			if (_board[target] == Cell::Empty and player_cover[target] > 0)
+			if (get(target) == Cell::Empty and cover(target, _turn) > 0 and filter(*this, target))
 			{
-				for (std::uint_fast8_t source = 0; source < num_cells; ++source)
+				std::uint_fast8_t blue_flags = get_blue_flags(target);
+				for (Index source = 0; source < num_cells; ++source)
 				{
-					if (_board[source] != _turn)
+					if (get(source) != _turn)
 					{
 						continue;
 					}
-					else if (player_cover[target] == 1 and std::ranges::contains(neighbors[target], source))
+					else if (cover(target, _turn) == 1 and std::ranges::contains(Board::neighbors[target], source))
 					{
 						continue;
 					}
-					std::uint_fast8_t blue_flags = 0;
-					for (auto [dir, neighbor] : neighbors[target] | std::views::enumerate)
-					{
-						if (_board[neighbor] == Cell::Blue)
-						{
-							blue_flags |= 1 << dir;
-						}
-					}
 					co_yield Move{.from = source, .to = target, .blue_flags = blue_flags};
 				}
 			}
 		}
 	}
 
-	std::generator<std::uint_fast8_t> get_possible_spawns() const
+	/// The cells accepted by the filter that the player to move can move a piece to
+	template <typename Filter = AllTargets>
+	std::generator<Index> targets(Filter filter = {}) const
+	{
+		LIBASSERT_DEBUG_ASSERT(_turn == Cell::Green or _turn == Cell::Purple);
+
+		for (Index target = 0; target < num_cells; ++target)
+		{
+			if (get(target) == Cell::Empty and cover(target, _turn) > 0 and filter(*this, target))
+			{
+				co_yield target;
+			}
+		}
+	}
+
+	/// The number of legal moves to the targets accepted by the filter, from the cover counts alone
+	template <typename Filter = AllTargets>
+	int count_moves(Filter filter = {}) const
 	{
-		for (std::uint_fast8_t idx = 0; idx < num_cells; ++idx)
+		LIBASSERT_DEBUG_ASSERT(_turn == Cell::Green or _turn == Cell::Purple);
+		int const player_count = _turn == Cell::Green ? _green_count : _purple_count;
+
+		int count = 0;
+		for (Index target = 0; target < num_cells; ++target)
 		{
-			if ((_board[idx] == Cell::Empty)
-				and (_green_cover[idx] == 0)
-				and (_purple_cover[idx] == 0)
-				and (_blue_cover[idx] == 0))
-				co_yield idx;
+			if (get(target) == Cell::Empty and cover(target, _turn) > 0 and filter(*this, target))
+			{
+				// A target covered only once cannot be reached by the piece covering it
+				count += player_count - (cover(target, _turn) == 1);
+			}
 		}
+		return count;
 	}
 
-	void unset(std::uint_fast8_t idx)
+	/// The legal moves grouped by target, each target's sources ordered from the least cover lost to the most
+	/// and cut to at most `max_sources`. Sources that lose no cover give children that differ only in the vacated cell.
+	template <typename Filter = AllTargets>
+	std::generator<Move> grouped_moves(int max_sources, Filter filter = {}) const
 	{
-		switch (_board[idx])
+		LIBASSERT_DEBUG_ASSERT(_turn == Cell::Green or _turn == Cell::Purple);
+
+		std::array<SourceEffect, num_cells> effects;
+		for (Index target = 0; target < num_cells; ++target)
 		{
-		case Cell::Empty: return;
-		case Cell::Green:
-			for (auto neighbor : neighbors[idx])
+			if (get(target) != Cell::Empty or cover(target, _turn) == 0 or not filter(*this, target))
 			{
-				--_green_cover[neighbor];
+				continue;
 			}
-			--_green_count;
-			break;
-		case Cell::Purple:
-			for (auto neighbor : neighbors[idx])
+			std::size_t count = 0;
+			for (Index source = 0; source < num_cells; ++source)
 			{
-				--_purple_cover[neighbor];
+				if (get(source) != _turn)
+				{
+					continue;
+				}
+				else if (cover(target, _turn) == 1 and std::ranges::contains(Board::neighbors[target], source))
+				{
+					continue;
+				}
+				effects[count++] = source_effect(source, target);
 			}
-			--_purple_count;
-			break;
-		case Cell::Blue:
-			for (auto neighbor : neighbors[idx])
+			std::ranges::stable_sort(effects.begin(), effects.begin() + count, {}, &SourceEffect::lost_cover);
+			std::uint_fast8_t blue_flags = get_blue_flags(target);
+			for (auto const &effect : effects | std::views::take(std::min<std::size_t>(count, max_sources)))
 			{
-				--_blue_cover[neighbor];
+				co_yield Move{.from = effect.source, .to = target, .blue_flags = blue_flags};
 			}
-			break;
-		default: std::unreachable();
 		}
-		_hash ^= zobrist_table.cell_table[idx * 3 + std::to_underlying(_board[idx]) - 1];
-		_board[idx] = Cell::Empty;
 	}
 
-	void set(std::uint_fast8_t idx, Cell cell)
+	/// The number of distinct source effects over the targets: per target, one shared by all the sources that lose
+	/// no cover and one for every other source. Every move still gives a different child, as the vacated cells differ.
+	template <typename Filter = AllTargets>
+	int count_source_effects(Filter filter = {}) const
 	{
-		LIBASSERT_DEBUG_ASSERT(_board[idx] != Cell::Green);
-		LIBASSERT_DEBUG_ASSERT(_board[idx] != Cell::Purple);
-		LIBASSERT_DEBUG_ASSERT(cell != Cell::Empty);
-		if (_board[idx] == Cell::Blue)
+		LIBASSERT_DEBUG_ASSERT(_turn == Cell::Green or _turn == Cell::Purple);
+
+		int count = 0;
+		for (Index target = 0; target < num_cells; ++target)
+		{
+			if (get(target) != Cell::Empty or cover(target, _turn) == 0 or not filter(*this, target))
+			{
+				continue;
+			}
+			bool harmless = false;
+			for (Index source = 0; source < num_cells; ++source)
+			{
+				if (get(source) != _turn)
+				{
+					continue;
+				}
+				else if (cover(target, _turn) == 1 and std::ranges::contains(Board::neighbors[target], source))
+				{
+					continue;
+				}
+				else if (source_effect(source, target).lost_cover == 0)
+				{
+					harmless = true;
+				}
+				else
+				{
+					++count;
+				}
+			}
+			count += harmless;
+		}
+		return count;
+	}
+
+	/// The cover lost by moving the piece on `source` to `target`, which itself covers the target's neighbors
+	SourceEffect source_effect(Index source, Index target) const
+	{
+		LIBASSERT_DEBUG_ASSERT(get(source) == _turn);
+		std::uint_fast8_t lost_cover = 0;
+		for (auto neighbor : Board::neighbors[source])
+		{
+			lost_cover += cover(neighbor, _turn) == 1 and neighbor != target
+				and not std::ranges::contains(Board::neighbors[target], neighbor);
+		}
+		return {.source = source, .lost_cover = lost_cover};
+	}
+
+	/// Whether a move to the cell would capture a blue
+	bool is_capture_target(Index idx) const { return cover(idx, Cell::Blue) > 0; }
+
+	/// Picks a legal move uniformly at random from the cover counts, without enumerating the moves
+	template <std::uniform_random_bit_generator Engine>
+	std::optional<Move> random_legal_move(Engine &engine) const
+	{
+		LIBASSERT_DEBUG_ASSERT(_turn == Cell::Green or _turn == Cell::Purple);
+		int const player_count = _turn == Cell::Green ? _green_count : _purple_count;
+
+		// A target covered only once cannot be reached by the piece covering it
+		auto source_count = [&](Index target)
+		{
+			return get(target) == Cell::Empty and cover(target, _turn) > 0
+				? player_count - (cover(target, _turn) == 1)
+				: 0;
+		};
+
+		int total = 0;
+		for (Index target = 0; target < num_cells; ++target)
+		{
+			total += source_count(target);
+		}
+		if (total == 0)
+		{
+			return std::nullopt;
+		}
+
+		int pick = std::uniform_int_distribution<int>{0, total - 1}(engine);
+		Index target = 0;
+		while (pick >= source_count(target))
+		{
+			pick -= source_count(target);
+			++target;
+		}
+
+		Index excluded = num_cells;
+		if (cover(target, _turn) == 1)
+		{
+			excluded = *std::ranges::find_if(Board::neighbors[target], [&](auto neighbor) { return get(neighbor) == _turn; });
+		}
+		Index source = 0;
+		for (;; ++source)
 		{
-			_hash ^= zobrist_table.cell_table[idx * 3 + std::to_underlying(Cell::Blue) - 1];
+			if (get(source) == _turn and source != excluded and pick-- == 0)
+			{
+				break;
+			}
 		}
-		_board[idx] = cell;
-		_hash ^= zobrist_table.cell_table[idx * 3 + std::to_underlying(cell) - 1];
-		switch (cell)
+		return Move{.from = source, .to = target, .blue_flags = get_blue_flags(target)};
+	}
+
+	std::generator<Index> get_possible_spawns() const
+	{
+		for (Index idx = 0; idx < num_cells; ++idx)
 		{
-		case Cell::Green:
-			for (auto neighbor : neighbors[idx])
+			if (is_possible_spawn(idx))
+				co_yield idx;
+		}
+	}
+
+	/// Steps between neighbors from every cell to the nearest piece of any color, blue included.
+	/// Cells of an empty board are at the largest distance the type holds.
+	std::array<std::uint8_t, num_cells> piece_distances() const
+	{
+		constexpr std::uint8_t unreached = std::numeric_limits<std::uint8_t>::max();
+		std::array<std::uint8_t, num_cells> distances;
+		distances.fill(unreached);
+		// Breadth-first from every piece at once
+		std::array<Index, num_cells> queue;
+		std::size_t end = 0;
+		for (Index idx = 0; idx < num_cells; ++idx)
+		{
+			if (get(idx) != Cell::Empty)
 			{
-				++_green_cover[neighbor];
+				distances[idx] = 0;
+				queue[end++] = idx;
 			}
-			++_green_count;
-			break;
-		case Cell::Purple:
-			for (auto neighbor : neighbors[idx])
+		}
+		for (std::size_t begin = 0; begin < end; ++begin)
+		{
+			for (auto neighbor : Board::neighbors[queue[begin]])
 			{
-				++_purple_cover[neighbor];
+				if (distances[neighbor] == unreached)
+				{
+					distances[neighbor] = distances[queue[begin]] + 1;
+					queue[end++] = neighbor;
+				}
 			}
-			++_purple_count;
-			break;
-		case Cell::Blue:
-			for (auto neighbor : neighbors[idx])
+		}
+		return distances;
+	}
+
+	/// Rolls for a blue spawn after a move and places it on a uniformly chosen spawn cell
+	template <std::uniform_random_bit_generator Engine>
+	std::optional<Index> maybe_spawn_blue(Engine &engine)
+	{
+		if (std::uniform_int_distribution<int>{1, blue_spawn_odds}(engine) != 1)
+		{
+			return std::nullopt;
+		}
+		std::array<Index, num_cells> spawns;
+		std::size_t count = 0;
+		for (Index idx = 0; idx < num_cells; ++idx)
+		{
+			if (is_possible_spawn(idx))
 			{
-				++_blue_cover[neighbor];
+				spawns[count++] = idx;
 			}
-			break;
-		default: std::unreachable();
 		}
+		if (count == 0)
+		{
+			return std::nullopt;
+		}
+		Index idx = spawns[std::uniform_int_distribution<std::size_t>{0, count - 1}(engine)];
+		set(idx, Cell::Blue);
+		return idx;
+	}
+
+	void unset(Index idx)
+	{
+		Cell const cell = get(idx);
+		if (cell == Cell::Empty)
+		{
+			return;
+		}
+		for (auto neighbor : Board::neighbors[idx])
+		{
+			--_cells[neighbor][std::to_underlying(cell)];
+		}
+		_green_count -= cell == Cell::Green;
+		_purple_count -= cell == Cell::Purple;
+		_hash ^= zobrist_table<num_cells>.key(idx, cell);
+		_cells[idx][0] = std::to_underlying(Cell::Empty);
+		verify();
+	}
+
+	void set(Index idx, Cell cell)
+	{
+		LIBASSERT_DEBUG_ASSERT(get(idx) != Cell::Green);
+		LIBASSERT_DEBUG_ASSERT(get(idx) != Cell::Purple);
+		LIBASSERT_DEBUG_ASSERT(cell != Cell::Empty);
+		if (get(idx) == Cell::Blue)
+		{
+			unset(idx);
+		}
+		_cells[idx][0] = std::to_underlying(cell);
+		_hash ^= zobrist_table<num_cells>.key(idx, cell);
+		for (auto neighbor : Board::neighbors[idx])
+		{
+			++_cells[neighbor][std::to_underlying(cell)];
+		}
+		_green_count += cell == Cell::Green;
+		_purple_count += cell == Cell::Purple;
+		verify();
 	}
 
-	// TODO: Incremental hash
 	std::uint64_t hash() const { return _hash; }
 	int heuristic() const
 	{
-		return (_turn == Cell::Green ? _green_count - _purple_count : _purple_count - _green_count) * 1000;
+		if constexpr (std::ranges::all_of(evaluation_weights | std::views::drop(1), [](int w) { return w == 0; }))
+		{
+			return (_turn == Cell::Green ? _green_count - _purple_count : _purple_count - _green_count)
+				* evaluation_weights[0];
+		}
+		else
+		{
+			auto terms = features();
+			int score = 0;
+			for (std::size_t i = 0; i < num_features; ++i)
+			{
+				score += terms[i] * evaluation_weights[i];
+			}
+			return score;
+		}
+	}
+
+	/// Evaluation terms from the perspective of the player to move
+	std::array<int, num_features> features() const
+	{
+		int mobility = 0;
+		int capture_targets = 0;
+		int isolated_pieces = 0;
+		for (Index idx = 0; idx < num_cells; ++idx)
+		{
+			switch (get(idx))
+			{
+			case Cell::Empty:
+			{
+				int cover_difference = (cover(idx, Cell::Green) > 0) - (cover(idx, Cell::Purple) > 0);
+				mobility += cover_difference;
+				if (cover(idx, Cell::Blue) > 0)
+				{
+					capture_targets += cover_difference;
+				}
+				break;
+			}
+			case Cell::Green: isolated_pieces += cover(idx, Cell::Green) == 0; break;
+			case Cell::Purple: isolated_pieces -= cover(idx, Cell::Purple) == 0; break;
+			case Cell::Blue: break;
+			}
+		}
+		int sign = _turn == Cell::Green ? 1 : -1;
+		return {
+			sign * (_green_count - _purple_count),
+			sign * mobility,
+			sign * capture_targets,
+			sign * isolated_pieces,
+		};
 	}
 
 	int green_count() const { return _green_count; }
 	int purple_count() const { return _purple_count; }
 
+	/// Whether the player to move has at least one legal move
+	bool has_legal_moves() const
+	{
+		LIBASSERT_DEBUG_ASSERT(_turn == Cell::Green or _turn == Cell::Purple);
+		int player_count = _turn == Cell::Green ? _green_count : _purple_count;
+		if (player_count < 2)
+		{
+			return false;
+		}
+		for (Index idx = 0; idx < num_cells; ++idx)
+		{
+			if (get(idx) == Cell::Empty and cover(idx, _turn) > 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// The winner of the game, or Cell::Empty while the game is still in progress
+	Cell winner() const
+	{
+		if (_green_count >= winning_count)
+		{
+			return Cell::Green;
+		}
+		else if (_purple_count >= winning_count)
+		{
+			return Cell::Purple;
+		}
+		else if (not has_legal_moves())
+		{
+			return opponent(_turn);
+		}
+		return Cell::Empty;
+	}
+
 	Cell turn() const { return _turn; }
-	void turn(Cell turn) { _turn = turn; }
+	void turn(Cell turn)
+	{
+		if ((_turn == Cell::Green) != (turn == Cell::Green))
+		{
+			_hash ^= zobrist_table<num_cells>.is_green_move_hash;
+		}
+		_turn = turn;
+		verify();
+	}
 
   private:
-	Cell _turn = Cell::Empty;
+	/// Recomputes the hash, piece counts and cover from the pieces on the board and asserts that the incrementally
+	/// updated values match. Compiled out unless FLITSOLVER_VERIFY_STATE is defined.
+	void verify() const
+	{
+		if constexpr (verify_state)
+		{
+			std::uint64_t hash = _turn == Cell::Green ? zobrist_table<num_cells>.is_green_move_hash : 0;
+			int green_count = 0;
+			int purple_count = 0;
+			std::array<PackedCell, num_cells> cells{};
+			for (Index idx = 0; idx < num_cells; ++idx)
+			{
+				Cell const cell = get(idx);
+				cells[idx][0] = std::to_underlying(cell);
+				if (cell == Cell::Empty)
+				{
+					continue;
+				}
+				hash ^= zobrist_table<num_cells>.key(idx, cell);
+				green_count += cell == Cell::Green;
+				purple_count += cell == Cell::Purple;
+				for (auto neighbor : Board::neighbors[idx])
+				{
+					++cells[neighbor][std::to_underlying(cell)];
+				}
+			}
+			LIBASSERT_ASSERT(_hash == hash);
+			LIBASSERT_ASSERT(_green_count == green_count);
+			LIBASSERT_ASSERT(_purple_count == purple_count);
+			LIBASSERT_ASSERT(_cells == cells);
+		}
+	}
+
+	/// Direction flags of the blue pieces next to a cell
+	std::uint_fast8_t get_blue_flags(Index target) const
+	{
+		std::uint_fast8_t blue_flags = 0;
+		for (auto [dir, neighbor] : Board::neighbors[target] | std::views::enumerate)
+		{
+			if (get(neighbor) == Cell::Blue)
+			{
+				blue_flags |= 1 << dir;
+			}
+		}
+		return blue_flags;
+	}
+
+	bool is_possible_spawn(Index idx) const
+	{
+		return (get(idx) == Cell::Empty)
+			and (cover(idx, Cell::Green) == 0)
+			and (cover(idx, Cell::Purple) == 0)
+			and (cover(idx, Cell::Blue) == 0);
+	}
+
+	/// Byte 0 holds the piece on the cell and byte i the cover of the color with Cell value i,
+	/// so a cell's piece and the cover around it share one word and a piece updates its neighbors' cover by index
+	using PackedCell = std::array<std::uint8_t, 4>;
+
+	alignas(64) std::array<PackedCell, num_cells> _cells = {};
+	std::uint64_t _hash = 0;
 	int _green_count = 0;
 	int _purple_count = 0;
-	std::uint64_t _hash = 0;
-	Cell _board[num_cells] = {};
-	std::uint8_t _green_cover[num_cells] = {};
-	std::uint8_t _purple_cover[num_cells] = {};
-	std::uint8_t _blue_cover[num_cells] = {};
-	friend std::string dump(flit::GameState const &state);
+	Cell _turn = Cell::Empty;
+	friend std::string dump<Rows, Cols>(BasicGameState const &state);
 };
 
-export std::string
-dump(flit::GameState const &state)
+/// The standard board
+export using GameState = BasicGameState<12, 12>;
+export using Move = GameState::Move;
+export using RegionTargets = BasicRegionTargets<GameState::num_cells>;
+// The state is copied for every search thread and snapshot, so keep it within ten cache lines
+static_assert(sizeof(GameState) <= 10 * 64);
+export constexpr std::uint_fast8_t rows = GameState::rows;
+export constexpr std::uint_fast8_t cols = GameState::cols;
+/// Number of pieces a player needs to win the game
+export constexpr int winning_count = GameState::winning_count;
+
+export constexpr GameState::Index
+from_rc(std::uint_fast8_t row, std::uint_fast8_t col) noexcept
+{
+	return GameState::Board::from_rc(row, col);
+}
+
+/// An empty board with two green and two purple pieces on random cells, green to move
+export template <typename State = GameState, std::uniform_random_bit_generator Engine>
+State
+random_start(Engine &engine)
+{
+	State state;
+	std::uniform_int_distribution<int> row_dist{0, State::rows - 1};
+	std::uniform_int_distribution<int> col_dist{0, State::cols - 1};
+
+	auto try_set = [&](Cell cell)
+	{
+		std::uint_fast8_t row;
+		std::uint_fast8_t col;
+		do
+		{
+			row = row_dist(engine);
+			col = col_dist(engine);
+		} while (state.get(row, col) != Cell::Empty);
+		state.set(row, col, cell);
+	};
+	try_set(Cell::Green);
+	try_set(Cell::Green);
+	try_set(Cell::Purple);
+	try_set(Cell::Purple);
+	state.turn(Cell::Green);
+	return state;
+}
+
+export template <std::uint_fast8_t Rows, std::uint_fast8_t Cols>
+std::string
+dump(BasicGameState<Rows, Cols> const &state)
 {
+	using Board = BasicGameState<Rows, Cols>::Board;
 	std::string out;
-	std::format_to(std::back_inserter(out), "{: ^{}}|{: ^{}}|{: ^{}}\n", "Board", cols, "Green", cols, "Purple", cols);
-	for (std::uint_fast8_t row = 0; row < flit::rows; ++row)
+	std::format_to(std::back_inserter(out), "{: ^{}}|{: ^{}}|{: ^{}}\n", "Board", Cols, "Green", Cols, "Purple", Cols);
+	for (std::uint_fast8_t row = 0; row < Rows; ++row)
 	{
-		for (std::uint_fast8_t col = 0; col < flit::cols; ++col)
+		for (std::uint_fast8_t col = 0; col < Cols; ++col)
 		{
 			char c = ".GPB"[static_cast<std::size_t>(state.get(row, col))];
 			out.push_back(c);
 		}
 		out.push_back('|');
-		for (std::uint_fast8_t col = 0; col < flit::cols; ++col)
+		for (std::uint_fast8_t col = 0; col < Cols; ++col)
 		{
-			char c = '0' + state._green_cover[flit::from_rc(row, col)];
+			char c = '0' + state.cover(Board::from_rc(row, col), Cell::Green);
 			out.push_back(c);
 		}
 		out.push_back('|');
-		for (std::uint_fast8_t col = 0; col < flit::cols; ++col)
+		for (std::uint_fast8_t col = 0; col < Cols; ++col)
 		{
-			char c = '0' + state._purple_cover[flit::from_rc(row, col)];
+			char c = '0' + state.cover(Board::from_rc(row, col), Cell::Purple);
 			out.push_back(c);
 		}
 		out.push_back('\n');
@@ -325,15 +856,15 @@ dump(flit::GameState const &state)
 
 } // namespace flit
 
-template <>
-struct std::formatter<flit::Move> : std::formatter<std::string_view>
+template <std::uint_fast8_t Rows, std::uint_fast8_t Cols>
+struct std::formatter<flit::BasicMove<Rows, Cols>> : std::formatter<std::string_view>
 {
-	auto format(const flit::Move &move, auto &ctx) const
+	auto format(const flit::BasicMove<Rows, Cols> &move, auto &ctx) const
 	{
-		int from_row = move.from / flit::cols + 1;
-		char from_col = move.from % flit::cols + 'A';
-		int to_row = move.to / flit::cols + 1;
-		char to_col = move.to % flit::cols + 'A';
+		int from_row = move.from / Cols + 1;
+		char from_col = move.from % Cols + 'A';
+		int to_row = move.to / Cols + 1;
+		char to_col = move.to % Cols + 'A';
 		return std::format_to(ctx.out(), "{}{}-{}{}", from_col, from_row, to_col, to_row);
 	}
 };
\ No newline at end of file
@@ -1,9 +1,12 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_container_properties.hpp>
 #include <catch2/matchers/catch_matchers_range_equals.hpp>
 #include <libassert/assert-catch2.hpp>
 
+#include <random>
 #include <ranges>
+#include <vector>
 
 import flit.game;
 
@@ -210,6 +213,97 @@ TEST_CASE("Moving adjacent to blue captures the blue")
 	}
 }
 
+TEST_CASE("Capture moves are the legal moves that capture blue", "[game]")
+{
+	flit::GameState state{};
+	state.set(4, 5, flit::Cell::Green);
+	state.set(5, 5, flit::Cell::Green);
+	state.set(9, 9, flit::Cell::Green);
+	state.set(5, 7, flit::Cell::Blue);
+	state.set(6, 6, flit::Cell::Blue);
+	state.set(0, 0, flit::Cell::Blue);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	std::vector expected = state.get_legal_moves()
+		| std::views::filter([](flit::Move move) { return move.blue_flags != 0; })
+		| std::ranges::to<std::vector>();
+	std::vector result = state.get_capture_moves() | std::ranges::to<std::vector>();
+
+	REQUIRE_THAT(result, SizeIs(expected.size()));
+	REQUIRE_THAT(result, UnorderedRangeEquals(expected));
+}
+
+TEST_CASE("Filtered move generators agree with filtering all moves", "[game]")
+{
+	flit::GameState state{};
+	state.set(4, 5, flit::Cell::Green);
+	state.set(5, 5, flit::Cell::Green);
+	state.set(5, 6, flit::Cell::Green);
+	state.set(5, 8, flit::Cell::Blue);
+	state.set(0, 0, flit::Cell::Purple);
+	state.set(0, 1, flit::Cell::Purple);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	std::vector all = state.get_legal_moves() | std::ranges::to<std::vector>();
+	auto filtered = [&](auto predicate)
+	{ return all | std::views::filter(predicate) | std::ranges::to<std::vector>(); };
+
+	flit::RegionTargets region;
+	for (std::uint_fast8_t col = 0; col < flit::cols; ++col)
+	{
+		region.region.set(flit::from_rc(4, col));
+	}
+	std::vector in_region = state.moves(region) | std::ranges::to<std::vector>();
+	ASSERT(not in_region.empty());
+	REQUIRE_THAT(in_region, UnorderedRangeEquals(filtered([](flit::Move move) { return move.to / flit::cols == 4; })));
+
+	std::vector quiet = state.moves(flit::QuietTargets{}) | std::ranges::to<std::vector>();
+	REQUIRE_THAT(quiet, UnorderedRangeEquals(filtered([](flit::Move move) { return move.blue_flags == 0; })));
+
+	ASSERT(state.count_moves() == static_cast<int>(all.size()));
+	ASSERT(state.count_moves(flit::CaptureTargets{}) == static_cast<int>(all.size() - quiet.size()));
+
+	std::vector targets = state.targets() | std::ranges::to<std::vector>();
+	std::vector all_targets = all | std::views::transform(&flit::Move::to) | std::ranges::to<std::vector>();
+	std::ranges::sort(all_targets);
+	auto [last, end] = std::ranges::unique(all_targets);
+	all_targets.erase(last, end);
+	REQUIRE_THAT(targets, UnorderedRangeEquals(all_targets));
+}
+
+TEST_CASE("Grouped moves prefer sources that lose no cover", "[game]")
+{
+	flit::GameState state{};
+	for (std::uint_fast8_t row = 4; row < 7; ++row)
+	{
+		for (std::uint_fast8_t col = 4; col < 8; ++col)
+		{
+			state.set(row, col, flit::Cell::Green);
+		}
+	}
+	state.set(9, 9, flit::Cell::Green);
+	state.set(0, 0, flit::Cell::Purple);
+	state.set(0, 1, flit::Cell::Purple);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	std::vector all = state.get_legal_moves() | std::ranges::to<std::vector>();
+	std::vector grouped = state.grouped_moves(flit::rows * flit::cols) | std::ranges::to<std::vector>();
+	REQUIRE_THAT(grouped, UnorderedRangeEquals(all));
+
+	// The pieces inside the block leave every cell covered
+	std::vector single = state.grouped_moves(1) | std::ranges::to<std::vector>();
+	REQUIRE_THAT(single, SizeIs(std::ranges::distance(state.targets())));
+	for (flit::Move move : single)
+	{
+		ASSERT(state.source_effect(move.from, move.to).lost_cover == 0);
+	}
+	ASSERT(state.source_effect(flit::from_rc(9, 9), flit::from_rc(3, 4)).lost_cover == 4);
+	ASSERT(state.count_source_effects() < state.count_moves());
+}
+
 TEST_CASE("Committing and uncommiting a move restores game hash", "[game]")
 {
 	SECTION("Without blue captures")
@@ -251,4 +345,196 @@ TEST_CASE("Committing and uncommiting a move restores game hash", "[game]")
 			ASSERT(premove_hash == uncommit_hash);
 		}
 	}
+}
+
+TEST_CASE("Hash after a move matches making it", "[game]")
+{
+	flit::GameState state{};
+	state.set(4, 5, flit::Cell::Green);
+	state.set(5, 5, flit::Cell::Green);
+	state.set(6, 6, flit::Cell::Blue);
+	state.set(0, 0, flit::Cell::Purple);
+	state.set(0, 1, flit::Cell::Purple);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	int captures = 0;
+	for (auto move : state.get_legal_moves() | std::ranges::to<std::vector>())
+	{
+		std::uint64_t const predicted = state.hash_after(move);
+		captures += move.blue_flags != 0;
+		state.commit(move);
+		ASSERT(state.hash() == predicted);
+		state.uncommit(move);
+	}
+	ASSERT(captures > 0);
+}
+
+TEST_CASE("Capturing a blue removes its cover", "[game]")
+{
+	flit::GameState state{};
+	state.set(4, 5, flit::Cell::Green);
+	state.set(5, 5, flit::Cell::Green);
+	state.set(5, 7, flit::Cell::Blue);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	flit::Move capture = *state.get_capture_moves().begin();
+	state.commit(capture);
+	for (auto idx : std::views::iota(0uz, flit::GameState::num_cells))
+	{
+		ASSERT(not state.is_capture_target(idx));
+	}
+	state.uncommit(capture);
+	ASSERT(state.get(5, 7) == flit::Cell::Blue);
+	ASSERT(state.cover(flit::from_rc(5, 6), flit::Cell::Blue) == 1);
+	ASSERT(state.cover(flit::from_rc(5, 6), flit::Cell::Green) == 1);
+}
+
+TEST_CASE("Player without legal moves loses", "[game]")
+{
+	flit::GameState state{};
+	state.set(4, 5, flit::Cell::Green);
+	state.set(5, 5, flit::Cell::Green);
+	state.set(0, 0, flit::Cell::Purple);
+	state.turn(flit::Cell::Purple);
+	INFO(flit::dump(state));
+	ASSERT(not state.has_legal_moves());
+	ASSERT(state.winner() == flit::Cell::Green);
+
+	state.set(0, 1, flit::Cell::Purple);
+	ASSERT(state.has_legal_moves());
+	ASSERT(state.winner() == flit::Cell::Empty);
+}
+
+TEST_CASE("Hashes are stable across builds", "[game]")
+{
+	// Persisted tables and books rely on these exact values
+	static_assert(flit::zobrist_table<144>.key(0, flit::Cell::Empty) == 0);
+	flit::GameState state{};
+	state.set(4, 5, flit::Cell::Green);
+	state.set(5, 5, flit::Cell::Green);
+	state.set(7, 5, flit::Cell::Blue);
+	state.set(11, 11, flit::Cell::Purple);
+	state.turn(flit::Cell::Purple);
+	ASSERT(state.hash() == 0x358c'b9cc'6ea5'fce7);
+	state.turn(flit::Cell::Green);
+	ASSERT(state.hash() == 0x50dd'a8a1'be84'459b);
+}
+
+TEST_CASE("Hash depends on the player to move", "[game]")
+{
+	flit::GameState state{};
+	state.set(4, 5, flit::Cell::Green);
+	state.set(5, 5, flit::Cell::Green);
+	state.turn(flit::Cell::Green);
+	std::uint64_t green_hash = state.hash();
+	state.turn(flit::Cell::Purple);
+	ASSERT(state.hash() != green_hash);
+	state.turn(flit::Cell::Green);
+	ASSERT(state.hash() == green_hash);
+}
+
+TEST_CASE("Neighbors wrap around rectangular boards", "[game]")
+{
+	using Board = flit::Board<4, 6>;
+	auto const &neighbors = Board::neighbors[Board::from_rc(0, 5)];
+	ASSERT(neighbors[0] == Board::from_rc(3, 5));
+	ASSERT(neighbors[1] == Board::from_rc(1, 5));
+	ASSERT(neighbors[2] == Board::from_rc(0, 0));
+	ASSERT(neighbors[3] == Board::from_rc(0, 4));
+
+	auto const &corner = Board::neighbors[Board::from_rc(3, 0)];
+	ASSERT(corner[0] == Board::from_rc(2, 0));
+	ASSERT(corner[1] == Board::from_rc(0, 0));
+	ASSERT(corner[2] == Board::from_rc(3, 1));
+	ASSERT(corner[3] == Board::from_rc(3, 5));
+}
+
+TEST_CASE("Small boards play like the standard board", "[game]")
+{
+	using State = flit::BasicGameState<6, 6>;
+	State state{};
+	state.set(2, 2, flit::Cell::Green);
+	state.set(3, 2, flit::Cell::Green);
+	state.set(3, 4, flit::Cell::Blue);
+	state.set(0, 0, flit::Cell::Purple);
+	state.set(0, 1, flit::Cell::Purple);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	std::vector captures = state.get_capture_moves() | std::ranges::to<std::vector>();
+	REQUIRE_THAT(captures, SizeIs(1));
+	ASSERT(captures[0].from == State::Board::from_rc(2, 2));
+	ASSERT(captures[0].to == State::Board::from_rc(3, 3));
+
+	std::uint64_t hash = state.hash();
+	state.commit(captures[0]);
+	ASSERT(state.get(3, 4) == flit::Cell::Green);
+	ASSERT(state.green_count() == 3);
+	state.uncommit(captures[0]);
+	ASSERT(state.hash() == hash);
+	ASSERT(State::winning_count == 12);
+}
+
+TEST_CASE("Piece distances wrap around the board", "[game]")
+{
+	using State = flit::BasicGameState<6, 6>;
+	State state{};
+	ASSERT(state.piece_distances()[0] == 255);
+
+	state.set(0, 0, flit::Cell::Green);
+	state.set(3, 3, flit::Cell::Blue);
+	INFO(flit::dump(state));
+	auto distances = state.piece_distances();
+	ASSERT(distances[State::Board::from_rc(0, 0)] == 0);
+	ASSERT(distances[State::Board::from_rc(3, 3)] == 0);
+	ASSERT(distances[State::Board::from_rc(5, 5)] == 2);
+	ASSERT(distances[State::Board::from_rc(1, 2)] == 3);
+	ASSERT(distances[State::Board::from_rc(2, 3)] == 1);
+	// Every spawn cell is uncovered, so at least two steps from any piece
+	for (auto idx : state.get_possible_spawns())
+	{
+		ASSERT(distances[idx] >= 2);
+	}
+}
+
+TEST_CASE("Large boards use wider cell indices", "[game]")
+{
+	using State = flit::BasicGameState<20, 20>;
+	static_assert(sizeof(State::Index) == 2);
+	static_assert(sizeof(flit::GameState::Index) == 1);
+	State state{};
+	state.set(19, 19, flit::Cell::Green);
+	state.set(19, 18, flit::Cell::Green);
+	state.turn(flit::Cell::Green);
+	ASSERT(state.count_moves() == 6);
+	for (auto move : state.get_legal_moves())
+	{
+		ASSERT(move.to < State::num_cells);
+	}
+}
+
+TEST_CASE("Game state update and copy cost", "[.benchmark][game]")
+{
+	std::mt19937 engine{1};
+	flit::GameState state = flit::random_start(engine);
+	for (int i = 0; i < 20 and state.winner() == flit::Cell::Empty; ++i)
+	{
+		state.commit(*state.random_legal_move(engine));
+		state.maybe_spawn_blue(engine);
+	}
+	std::vector moves = state.get_legal_moves() | std::ranges::to<std::vector>();
+	WARN("sizeof(GameState): " << sizeof(flit::GameState));
+
+	BENCHMARK("Commit and uncommit every legal move")
+	{
+		for (flit::Move move : moves)
+		{
+			state.commit(move);
+			state.uncommit(move);
+		}
+		return state.hash();
+	};
+	BENCHMARK("Copy") { return flit::GameState{state}; };
 }
\ No newline at end of file
@@ -0,0 +1,153 @@
+module;
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include <sys/mman.h>
+
+export module flit.huge_pages;
+
+namespace flit
+{
+
+/// Size of the huge pages backing large tables
+export constexpr std::size_t huge_page_size = std::size_t{2} << 20;
+
+export enum class PageKind {
+	/// Regular pages, when the kernel supports neither kind of huge page
+	Normal,
+	/// Regular pages the kernel was advised to merge into transparent huge pages
+	Transparent,
+	/// Pages from the explicitly reserved huge page pool
+	Explicit,
+	/// Pages of a shared memory segment, of whichever kind the kernel backs it with
+	Shared,
+};
+
+export constexpr std::string_view
+page_kind_name(PageKind kind)
+{
+	switch (kind)
+	{
+	case PageKind::Normal: return "normal pages";
+	case PageKind::Transparent: return "transparent huge pages";
+	case PageKind::Explicit: return "explicit huge pages";
+	case PageKind::Shared: return "shared memory";
+	}
+	return "unknown pages";
+}
+
+namespace
+{
+
+struct Mapping
+{
+	void *data;
+	std::size_t size;
+	PageKind kind;
+};
+
+/// Maps zeroed memory on huge pages where possible, aligned to the huge page size either way
+Mapping
+map_huge_pages(std::size_t bytes)
+{
+	std::size_t const size = (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+#ifdef MAP_HUGETLB
+	if (void *data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		data != MAP_FAILED)
+	{
+		return {data, size, PageKind::Explicit};
+	}
+#endif
+	// Over-allocate and trim, so transparent huge pages can back the whole table
+	void *mapping = ::mmap(nullptr, size + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mapping == MAP_FAILED)
+	{
+		throw std::bad_alloc{};
+	}
+	auto const begin = reinterpret_cast<std::uintptr_t>(mapping);
+	auto const aligned = (begin + huge_page_size - 1) / huge_page_size * huge_page_size;
+	if (aligned > begin)
+	{
+		::munmap(mapping, aligned - begin);
+	}
+	if (std::size_t const tail = begin + huge_page_size - aligned; tail > 0)
+	{
+		::munmap(reinterpret_cast<void *>(aligned + size), tail);
+	}
+	void *data = reinterpret_cast<void *>(aligned);
+	PageKind kind = PageKind::Normal;
+#ifdef MADV_HUGEPAGE
+	if (::madvise(data, size, MADV_HUGEPAGE) == 0)
+	{
+		kind = PageKind::Transparent;
+	}
+#endif
+	return {data, size, kind};
+}
+
+} // namespace
+
+/// A fixed-size array of zero-initialised trivial objects on huge pages, for tables probed at random.
+/// The kernel zeroes pages on first touch, so allocating is cheap and each page lands on the NUMA node of the thread
+/// that first uses it.
+export template <typename T>
+	requires std::is_trivially_default_constructible_v<T> and std::is_trivially_destructible_v<T>
+class HugePageArray
+{
+  public:
+	HugePageArray() = default;
+
+	explicit HugePageArray(std::size_t size) : _size{size}
+	{
+		if (size == 0)
+		{
+			return;
+		}
+		Mapping mapping = map_huge_pages(size * sizeof(T));
+		_data = static_cast<T *>(mapping.data);
+		_mapped_size = mapping.size;
+		_kind = mapping.kind;
+	}
+
+	HugePageArray(HugePageArray &&other) noexcept
+		: _data{std::exchange(other._data, nullptr)}, _size{std::exchange(other._size, 0)},
+		  _mapped_size{std::exchange(other._mapped_size, 0)}, _kind{other._kind}
+	{
+	}
+
+	HugePageArray &operator=(HugePageArray &&other) noexcept
+	{
+		std::swap(_data, other._data);
+		std::swap(_size, other._size);
+		std::swap(_mapped_size, other._mapped_size);
+		std::swap(_kind, other._kind);
+		return *this;
+	}
+
+	~HugePageArray()
+	{
+		if (_data)
+		{
+			::munmap(_data, _mapped_size);
+		}
+	}
+
+	T &operator[](std::size_t idx) { return _data[idx]; }
+	T const &operator[](std::size_t idx) const { return _data[idx]; }
+
+	std::size_t size() const { return _size; }
+	PageKind page_kind() const { return _kind; }
+
+  private:
+	T *_data = nullptr;
+	std::size_t _size = 0;
+	std::size_t _mapped_size = 0;
+	PageKind _kind = PageKind::Normal;
+};
+
+} // namespace flit
\ No newline at end of file
@@ -1,7 +1,141 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <print>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+import flit.batch;
+import flit.cli;
+import flit.engine;
+import flit.evaluator;
+import flit.playout;
 import flit.repl;
+import flit.retrograde;
+import flit.selfplay;
+
+namespace
+{
+
+flit::SearchOptions
+search_options(flit::Arguments const &args)
+{
+	flit::SearchOptions options;
+	options.quiescence = not args.has("no-quiescence");
+	options.late_move_reductions = args.has("lmr");
+	options.reduction_move_count = args.get("lmr-moves", options.reduction_move_count);
+	options.reduction_min_depth = args.get("lmr-depth", options.reduction_min_depth);
+	options.futility_pruning = args.has("futility");
+	options.futility_margin = args.get("futility-margin", options.futility_margin);
+	options.max_sources = args.get("max-sources", options.max_sources);
+	options.multipv = std::max(1, args.get("multipv", options.multipv));
+	options.repetition_score = args.get("repetition-score", options.repetition_score);
+	return options;
+}
+
+/// Transposition table entries from `--tt-mb` in megabytes, or `--tt-size` in entries
+std::size_t
+transposition_table_size(flit::Arguments const &args, std::size_t fallback)
+{
+	if (args.has("tt-mb"))
+	{
+		return flit::Solver::transposition_table_entries(args.get("tt-mb", std::size_t{0}));
+	}
+	return args.get("tt-size", fallback);
+}
+
+} // namespace
 
 int
-main()
+main(int argc, char **argv)
 {
-	flit::repl();
+	try
+	{
+		flit::Arguments args{argc, argv};
+		if (args.empty())
+		{
+			flit::repl();
+		}
+		else if (args.has("engine"))
+		{
+			flit::engine();
+		}
+		else if (args.has("analyze"))
+		{
+			flit::AnalyzeOptions options{
+				.input = std::string{args.get("analyze")},
+				.output = std::string{args.get("output", "")},
+				.depth = args.get("depth", 1),
+			};
+			options.threads = args.get("threads", options.threads);
+			options.transposition_table_size = transposition_table_size(args, options.transposition_table_size);
+			options.shared_transposition_table = std::string{args.get("tt-shared", "")};
+			options.network = std::string{args.get("network", "")};
+			options.search = search_options(args);
+			if (auto format = args.get("format", "csv"); format == "jsonl")
+			{
+				options.format = flit::OutputFormat::JsonLines;
+			}
+			else if (format != "csv")
+			{
+				throw std::runtime_error{"Unknown output format"};
+			}
+			flit::analyze(options);
+		}
+		else if (args.has("selfplay"))
+		{
+			flit::SelfPlayOptions options{
+				.output = std::string{args.get("selfplay")},
+				.depth = args.get("depth", 1),
+			};
+			options.games = args.get("games", options.games);
+			options.threads = args.get("threads", options.threads);
+			options.shards = args.get("shards", options.shards);
+			options.dedupe_size = args.get("dedupe-size", options.dedupe_size);
+			options.random_plies = args.get("random-plies", options.random_plies);
+			options.max_plies = args.get("max-plies", options.max_plies);
+			options.seed = args.get("seed", options.seed);
+			options.transposition_table_size = transposition_table_size(args, options.transposition_table_size);
+			options.shared_transposition_table = std::string{args.get("tt-shared", "")};
+			options.network = std::string{args.get("network", "")};
+			options.search = search_options(args);
+			flit::self_play(options);
+		}
+		else if (args.has("retrograde"))
+		{
+			flit::RetrogradeOptions options{.output = std::string{args.get("retrograde")}};
+			options.rows = args.get("rows", options.rows);
+			options.cols = args.get("cols", options.cols);
+			options.threads = args.get("threads", options.threads);
+			options.max_sweeps = args.get("max-sweeps", options.max_sweeps);
+			flit::build_retrograde_table(options);
+		}
+		else if (args.has("bench-playouts"))
+		{
+			std::mt19937_64 engine{args.get("seed", std::uint64_t{1})};
+			flit::GameState start = flit::random_start(engine);
+			auto result = flit::measure_playouts(
+				start,
+				engine,
+				std::chrono::milliseconds{args.get("time-ms", 1000)},
+				args.get("max-plies", flit::default_playout_plies));
+			std::println(
+				"{} playouts, {:.0f} playouts/s, {:.0f} plies/s",
+				result.playouts,
+				result.playouts_per_second(),
+				result.plies_per_second());
+		}
+		else
+		{
+			throw std::runtime_error{"Usage: solver [--engine | --analyze <positions> | --selfplay <output prefix> | --retrograde <table> | --bench-playouts] [options]"};
+		}
+	}
+	catch (std::exception &ex)
+	{
+		std::println(stderr, "{}", ex.what());
+		return 1;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,224 @@
+module;
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+export module flit.mapped_file;
+
+namespace flit
+{
+
+namespace
+{
+
+/// How long to wait for the process creating a shared memory segment to size it, before taking the task over
+constexpr std::chrono::seconds shared_memory_timeout{5};
+
+[[noreturn]] void
+throw_system_error(std::string const &what, std::string const &path)
+{
+	throw std::runtime_error{std::format("{} {}: {}", what, path, std::strerror(errno))};
+}
+
+/// Sizes a shared memory segment unless a process already has, returning its size. The lock keeps two processes from
+/// sizing it at once, and the kernel releases it should its holder die.
+std::size_t
+size_shared_memory(int fd, std::size_t size, std::string const &path)
+{
+	if (::flock(fd, LOCK_EX) != 0)
+	{
+		::close(fd);
+		throw_system_error("Could not lock shared memory", path);
+	}
+	struct stat status;
+	bool const sized
+		= ::fstat(fd, &status) == 0 and (status.st_size > 0 or ::ftruncate(fd, static_cast<off_t>(size)) == 0);
+	int const error = errno;
+	::flock(fd, LOCK_UN);
+	if (not sized)
+	{
+		::close(fd);
+		errno = error;
+		throw_system_error("Could not resize shared memory", path);
+	}
+	return status.st_size > 0 ? static_cast<std::size_t>(status.st_size) : size;
+}
+
+} // namespace
+
+/// A file or shared memory segment mapped into memory, shared with the file on disk
+export class MappedFile
+{
+  public:
+	/// Creates the file, or resizes an existing one, and maps it for reading and writing
+	static MappedFile create(std::string const &path, std::size_t size)
+	{
+		int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+		if (fd < 0)
+		{
+			throw_system_error("Could not open", path);
+		}
+		if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+		{
+			::close(fd);
+			throw_system_error("Could not resize", path);
+		}
+		return MappedFile{fd, size, true, path};
+	}
+
+	/// Opens the named POSIX shared memory segment for reading and writing, creating it with the given size if it does
+	/// not exist yet. An existing segment keeps its size, unless its creator died before sizing it. The segment
+	/// outlives every process using it until unlinked.
+	static MappedFile shared_memory(std::string const &name, std::size_t size)
+	{
+		std::string const path = name.starts_with('/') ? name : '/' + name;
+		// Only the process creating the segment sizes it, so a mapping is never truncated under another process
+		int fd = ::shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd >= 0)
+		{
+			std::size_t actual = 0;
+			try
+			{
+				actual = size_shared_memory(fd, size, path);
+			}
+			catch (...)
+			{
+				::shm_unlink(path.c_str());
+				throw;
+			}
+			return MappedFile{fd, actual, true, path};
+		}
+		else if (errno != EEXIST or (fd = ::shm_open(path.c_str(), O_RDWR, 0600)) < 0)
+		{
+			throw_system_error("Could not open shared memory", path);
+		}
+		// The creator may not have sized it yet, or have died before it could
+		auto const deadline = std::chrono::steady_clock::now() + shared_memory_timeout;
+		struct stat status;
+		while (true)
+		{
+			if (::fstat(fd, &status) != 0)
+			{
+				::close(fd);
+				throw_system_error("Could not stat shared memory", path);
+			}
+			else if (status.st_size > 0)
+			{
+				break;
+			}
+			else if (std::chrono::steady_clock::now() > deadline)
+			{
+				return MappedFile{fd, size_shared_memory(fd, size, path), true, path};
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds{1});
+		}
+		return MappedFile{fd, static_cast<std::size_t>(status.st_size), true, path};
+	}
+
+	/// Removes the named shared memory segment. Processes that have it mapped keep using it.
+	static void unlink_shared_memory(std::string const &name)
+	{
+		std::string const path = name.starts_with('/') ? name : '/' + name;
+		if (::shm_unlink(path.c_str()) != 0 and errno != ENOENT)
+		{
+			throw_system_error("Could not unlink shared memory", path);
+		}
+	}
+
+	/// Maps an existing file for reading
+	static MappedFile open(std::string const &path)
+	{
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			throw_system_error("Could not open", path);
+		}
+		struct stat status;
+		if (::fstat(fd, &status) != 0)
+		{
+			::close(fd);
+			throw_system_error("Could not stat", path);
+		}
+		return MappedFile{fd, static_cast<std::size_t>(status.st_size), false, path};
+	}
+
+	MappedFile(MappedFile &&other) noexcept
+		: _data{std::exchange(other._data, nullptr)}, _size{std::exchange(other._size, 0)},
+		  _writable{other._writable}
+	{
+	}
+
+	MappedFile &operator=(MappedFile &&other) noexcept
+	{
+		std::swap(_data, other._data);
+		std::swap(_size, other._size);
+		std::swap(_writable, other._writable);
+		return *this;
+	}
+
+	~MappedFile()
+	{
+		if (_data)
+		{
+			::munmap(_data, _size);
+		}
+	}
+
+	bool writable() const { return _writable; }
+
+	std::span<std::byte const> bytes() const { return {static_cast<std::byte const *>(_data), _size}; }
+
+	std::span<std::byte> writable_bytes()
+	{
+		if (not _writable)
+		{
+			throw std::runtime_error{"File is mapped read-only"};
+		}
+		return {static_cast<std::byte *>(_data), _size};
+	}
+
+	/// Writes changed pages back to the file
+	void flush()
+	{
+		if (_data and _writable)
+		{
+			::msync(_data, _size, MS_SYNC);
+		}
+	}
+
+  private:
+	MappedFile(int fd, std::size_t size, bool writable, std::string const &path) : _size{size}, _writable{writable}
+	{
+		if (size > 0)
+		{
+			void *data = ::mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+			if (data == MAP_FAILED)
+			{
+				::close(fd);
+				throw_system_error("Could not map", path);
+			}
+			_data = data;
+		}
+		::close(fd);
+	}
+
+	void *_data = nullptr;
+	std::size_t _size = 0;
+	bool _writable = false;
+};
+
+} // namespace flit
\ No newline at end of file
@@ -0,0 +1,448 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) and defined(__GNUC__)
+#include <immintrin.h>
+#endif
+
+export module flit.network;
+
+import flit.game;
+import flit.mapped_file;
+
+namespace flit
+{
+
+export constexpr std::array<char, 4> network_file_magic{'F', 'L', 'T', 'N'};
+export constexpr std::uint8_t network_file_version = 1;
+
+/// Neurons of the first layer, per perspective
+export constexpr std::size_t network_accumulator_size = 32;
+/// Neurons of the hidden layer, which reads both perspectives' first layer
+export constexpr std::size_t network_hidden_size = 16;
+/// Fixed-point shift of the hidden layer's sums and of the output scale
+export constexpr int network_shift = 6;
+
+/// Quantised parameters of a network, in the order they are stored after the file header
+export struct NetworkWeights
+{
+	/// One per hidden neuron
+	std::vector<std::int32_t> hidden_bias;
+	std::int32_t output_bias = 0;
+	/// Score of 2^network_shift units of output
+	std::int32_t output_scale = 1 << network_shift;
+	/// One per first layer neuron
+	std::vector<std::int16_t> feature_bias;
+	/// First layer neurons of every feature, feature by feature
+	std::vector<std::int16_t> feature_weights;
+	/// Weights of the player to move's then the opponent's first layer, hidden neuron by hidden neuron
+	std::vector<std::int8_t> hidden_weights;
+	/// One per hidden neuron
+	std::vector<std::int8_t> output_weights;
+};
+
+/// First layer activations from one player's perspective
+export using NetworkRow = std::array<std::int16_t, network_accumulator_size>;
+
+/// The first layer of a position from green's and purple's perspectives, kept up to date as pieces change
+export struct alignas(64) NetworkAccumulator
+{
+	std::array<NetworkRow, 2> perspectives;
+
+	bool operator==(NetworkAccumulator const &) const = default;
+};
+
+export enum class NetworkKernels {
+	Scalar,
+	Avx2,
+};
+
+namespace
+{
+
+constexpr std::size_t network_header_size = 8;
+constexpr std::size_t network_input_size = 2 * network_accumulator_size;
+
+/// Pointers to the layers of a network in a mapped file
+struct Layers
+{
+	std::int32_t const *hidden_bias;
+	std::int32_t output_bias;
+	std::int32_t output_scale;
+	std::int16_t const *feature_bias;
+	std::int16_t const *feature_weights;
+	std::int8_t const *hidden_weights;
+	std::int8_t const *output_weights;
+};
+
+constexpr std::size_t
+network_file_size(std::size_t features)
+{
+	return network_header_size + (network_hidden_size + 2) * sizeof(std::int32_t)
+		+ (features + 1) * network_accumulator_size * sizeof(std::int16_t)
+		+ network_hidden_size * (network_input_size + 1) * sizeof(std::int8_t);
+}
+
+void
+add_scalar(std::int16_t *row, std::int16_t const *weights)
+{
+	for (std::size_t i = 0; i < network_accumulator_size; ++i)
+	{
+		row[i] = static_cast<std::int16_t>(row[i] + weights[i]);
+	}
+}
+
+void
+subtract_scalar(std::int16_t *row, std::int16_t const *weights)
+{
+	for (std::size_t i = 0; i < network_accumulator_size; ++i)
+	{
+		row[i] = static_cast<std::int16_t>(row[i] - weights[i]);
+	}
+}
+
+std::int32_t
+forward_scalar(std::int16_t const *us, std::int16_t const *them, Layers const &layers)
+{
+	// Clipped ReLU of both perspectives, the player to move first
+	std::array<std::uint8_t, network_input_size> input;
+	for (std::size_t i = 0; i < network_accumulator_size; ++i)
+	{
+		input[i] = static_cast<std::uint8_t>(std::clamp<int>(us[i], 0, 127));
+		input[network_accumulator_size + i] = static_cast<std::uint8_t>(std::clamp<int>(them[i], 0, 127));
+	}
+	std::int32_t output = layers.output_bias;
+	for (std::size_t j = 0; j < network_hidden_size; ++j)
+	{
+		std::int32_t sum = layers.hidden_bias[j];
+		for (std::size_t i = 0; i < network_input_size; ++i)
+		{
+			sum += layers.hidden_weights[j * network_input_size + i] * input[i];
+		}
+		output += layers.output_weights[j] * std::clamp(sum >> network_shift, 0, 127);
+	}
+	return output;
+}
+
+#if defined(__x86_64__) and defined(__GNUC__)
+
+__attribute__((target("avx2"))) void
+add_avx2(std::int16_t *row, std::int16_t const *weights)
+{
+	for (std::size_t i = 0; i < network_accumulator_size; i += 16)
+	{
+		auto *lane = reinterpret_cast<__m256i *>(row + i);
+		auto const *weight = reinterpret_cast<__m256i const *>(weights + i);
+		_mm256_storeu_si256(lane, _mm256_add_epi16(_mm256_loadu_si256(lane), _mm256_loadu_si256(weight)));
+	}
+}
+
+__attribute__((target("avx2"))) void
+subtract_avx2(std::int16_t *row, std::int16_t const *weights)
+{
+	for (std::size_t i = 0; i < network_accumulator_size; i += 16)
+	{
+		auto *lane = reinterpret_cast<__m256i *>(row + i);
+		auto const *weight = reinterpret_cast<__m256i const *>(weights + i);
+		_mm256_storeu_si256(lane, _mm256_sub_epi16(_mm256_loadu_si256(lane), _mm256_loadu_si256(weight)));
+	}
+}
+
+/// Clipped ReLU of one perspective, packed to 32 bytes in order
+__attribute__((target("avx2"))) __m256i
+clip_avx2(std::int16_t const *row)
+{
+	__m256i const zero = _mm256_setzero_si256();
+	__m256i const low = _mm256_max_epi16(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(row)), zero);
+	__m256i const high = _mm256_max_epi16(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(row + 16)), zero);
+	// Saturating to 255 and then taking the minimum clips to 127; packing interleaves the 128-bit lanes
+	__m256i const packed = _mm256_min_epu8(_mm256_packus_epi16(low, high), _mm256_set1_epi8(127));
+	return _mm256_permute4x64_epi64(packed, 0b11'01'10'00);
+}
+
+__attribute__((target("avx2"))) std::int32_t
+horizontal_sum_avx2(__m256i sums)
+{
+	__m128i sum = _mm_add_epi32(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0b01'00'11'10));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0b10'11'00'01));
+	return _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("avx2"))) std::int32_t
+forward_avx2(std::int16_t const *us, std::int16_t const *them, Layers const &layers)
+{
+	__m256i const us_input = clip_avx2(us);
+	__m256i const them_input = clip_avx2(them);
+	__m256i const ones = _mm256_set1_epi16(1);
+	std::int32_t output = layers.output_bias;
+	for (std::size_t j = 0; j < network_hidden_size; ++j)
+	{
+		auto const *weights = reinterpret_cast<__m256i const *>(layers.hidden_weights + j * network_input_size);
+		// Inputs are at most 127, so the pairwise products cannot saturate
+		__m256i const us_sums = _mm256_madd_epi16(_mm256_maddubs_epi16(us_input, _mm256_loadu_si256(weights)), ones);
+		__m256i const them_sums
+			= _mm256_madd_epi16(_mm256_maddubs_epi16(them_input, _mm256_loadu_si256(weights + 1)), ones);
+		std::int32_t const sum = layers.hidden_bias[j] + horizontal_sum_avx2(_mm256_add_epi32(us_sums, them_sums));
+		output += layers.output_weights[j] * std::clamp(sum >> network_shift, 0, 127);
+	}
+	return output;
+}
+
+#endif
+
+} // namespace
+
+/// The fastest kernels the CPU runs
+export NetworkKernels
+best_network_kernels()
+{
+#if defined(__x86_64__) and defined(__GNUC__)
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return NetworkKernels::Avx2;
+	}
+#endif
+	return NetworkKernels::Scalar;
+}
+
+/// The board-independent layers of a network, evaluated with the chosen kernels
+export class NetworkLayers
+{
+  public:
+	NetworkLayers(std::span<std::byte const> bytes, std::size_t features, NetworkKernels kernels) : _kernels{kernels}
+	{
+		if (bytes.size() != network_file_size(features))
+		{
+			throw std::runtime_error{"Network file is truncated"};
+		}
+		std::byte const *next = bytes.data() + network_header_size;
+		auto take = [&]<typename T>(std::size_t count)
+		{
+			auto const *begin = reinterpret_cast<T const *>(next);
+			next += count * sizeof(T);
+			return begin;
+		};
+		_layers.hidden_bias = take.template operator()<std::int32_t>(network_hidden_size);
+		_layers.output_bias = *take.template operator()<std::int32_t>(1);
+		_layers.output_scale = *take.template operator()<std::int32_t>(1);
+		_layers.feature_bias = take.template operator()<std::int16_t>(network_accumulator_size);
+		_layers.feature_weights = take.template operator()<std::int16_t>(features * network_accumulator_size);
+		_layers.hidden_weights = take.template operator()<std::int8_t>(network_hidden_size * network_input_size);
+		_layers.output_weights = take.template operator()<std::int8_t>(network_hidden_size);
+		if (_kernels == NetworkKernels::Avx2 and best_network_kernels() != NetworkKernels::Avx2)
+		{
+			_kernels = NetworkKernels::Scalar;
+		}
+	}
+
+	void reset(NetworkRow &row) const { std::copy_n(_layers.feature_bias, network_accumulator_size, row.begin()); }
+
+	void add(NetworkRow &row, std::size_t feature) const
+	{
+		std::int16_t const *weights = _layers.feature_weights + feature * network_accumulator_size;
+#if defined(__x86_64__) and defined(__GNUC__)
+		if (_kernels == NetworkKernels::Avx2)
+		{
+			add_avx2(row.data(), weights);
+			return;
+		}
+#endif
+		add_scalar(row.data(), weights);
+	}
+
+	void subtract(NetworkRow &row, std::size_t feature) const
+	{
+		std::int16_t const *weights = _layers.feature_weights + feature * network_accumulator_size;
+#if defined(__x86_64__) and defined(__GNUC__)
+		if (_kernels == NetworkKernels::Avx2)
+		{
+			subtract_avx2(row.data(), weights);
+			return;
+		}
+#endif
+		subtract_scalar(row.data(), weights);
+	}
+
+	/// The score of the first layer from the perspective of the player to move and of the opponent
+	int evaluate(NetworkRow const &us, NetworkRow const &them) const
+	{
+		std::int32_t output;
+#if defined(__x86_64__) and defined(__GNUC__)
+		if (_kernels == NetworkKernels::Avx2)
+		{
+			output = forward_avx2(us.data(), them.data(), _layers);
+		}
+		else
+#endif
+		{
+			output = forward_scalar(us.data(), them.data(), _layers);
+		}
+		return static_cast<int>((std::int64_t{output} * _layers.output_scale) >> network_shift);
+	}
+
+	NetworkKernels kernels() const { return _kernels; }
+
+  private:
+	Layers _layers;
+	NetworkKernels _kernels;
+};
+
+/// A small quantised network evaluating positions of one board size, read from a memory mapped file.
+/// Its inputs are the pieces on every cell, as the player's own, the opponent's or blue, from green's and purple's
+/// perspectives. The first layer is kept up to date by adding and subtracting the weights of pieces that change.
+export template <std::uint_fast8_t Rows, std::uint_fast8_t Cols>
+class BasicNetwork
+{
+  public:
+	using State = BasicGameState<Rows, Cols>;
+	using Index = State::Index;
+	using Move = State::Move;
+	static constexpr std::size_t num_features = 3 * State::num_cells;
+
+	/// Maps a network file, checking that it belongs to this board size
+	static BasicNetwork open(std::string const &path, NetworkKernels kernels = best_network_kernels())
+	{
+		MappedFile file = MappedFile::open(path);
+		std::span<std::byte const> bytes = file.bytes();
+		if (bytes.size() < network_header_size
+			or std::memcmp(bytes.data(), network_file_magic.data(), network_file_magic.size()) != 0
+			or static_cast<std::uint8_t>(bytes[4]) != network_file_version
+			or static_cast<std::uint8_t>(bytes[5]) != Rows or static_cast<std::uint8_t>(bytes[6]) != Cols)
+		{
+			throw std::runtime_error{std::format("{} is not a network of this board size", path)};
+		}
+		return BasicNetwork{std::move(file), kernels};
+	}
+
+	/// Writes the weights to a network file
+	static void write(std::string const &path, NetworkWeights const &weights)
+	{
+		if (weights.hidden_bias.size() != network_hidden_size or weights.feature_bias.size() != network_accumulator_size
+			or weights.feature_weights.size() != num_features * network_accumulator_size
+			or weights.hidden_weights.size() != network_hidden_size * network_input_size
+			or weights.output_weights.size() != network_hidden_size)
+		{
+			throw std::runtime_error{"Network weights do not match the architecture"};
+		}
+		MappedFile file = MappedFile::create(path, network_file_size(num_features));
+		std::byte *next = file.writable_bytes().data();
+		auto put = [&](void const *data, std::size_t size)
+		{
+			std::memcpy(next, data, size);
+			next += size;
+		};
+		std::array<char, network_header_size> header{};
+		std::ranges::copy(network_file_magic, header.begin());
+		header[4] = static_cast<char>(network_file_version);
+		header[5] = static_cast<char>(Rows);
+		header[6] = static_cast<char>(Cols);
+		put(header.data(), header.size());
+		put(weights.hidden_bias.data(), weights.hidden_bias.size() * sizeof(std::int32_t));
+		put(&weights.output_bias, sizeof(std::int32_t));
+		put(&weights.output_scale, sizeof(std::int32_t));
+		put(weights.feature_bias.data(), weights.feature_bias.size() * sizeof(std::int16_t));
+		put(weights.feature_weights.data(), weights.feature_weights.size() * sizeof(std::int16_t));
+		put(weights.hidden_weights.data(), weights.hidden_weights.size());
+		put(weights.output_weights.data(), weights.output_weights.size());
+		file.flush();
+	}
+
+	/// The first layer of a position computed from scratch
+	NetworkAccumulator refresh(State const &state) const
+	{
+		NetworkAccumulator accumulator;
+		for (auto &row : accumulator.perspectives)
+		{
+			_layers.reset(row);
+		}
+		for (std::size_t idx = 0; idx < State::num_cells; ++idx)
+		{
+			if (Cell cell = state.get(static_cast<Index>(idx)); cell != Cell::Empty)
+			{
+				add(accumulator, static_cast<Index>(idx), cell);
+			}
+		}
+		return accumulator;
+	}
+
+	void add(NetworkAccumulator &accumulator, Index idx, Cell cell) const
+	{
+		_layers.add(accumulator.perspectives[0], feature(Cell::Green, idx, cell));
+		_layers.add(accumulator.perspectives[1], feature(Cell::Purple, idx, cell));
+	}
+
+	void remove(NetworkAccumulator &accumulator, Index idx, Cell cell) const
+	{
+		_layers.subtract(accumulator.perspectives[0], feature(Cell::Green, idx, cell));
+		_layers.subtract(accumulator.perspectives[1], feature(Cell::Purple, idx, cell));
+	}
+
+	/// Updates the first layer for a move about to be made in the given position
+	void commit(NetworkAccumulator &accumulator, State const &state, Move move) const
+	{
+		Cell const player = state.get(move.from);
+		remove(accumulator, move.from, player);
+		add(accumulator, move.to, player);
+		for (int i = 0; i < 4; ++i)
+		{
+			if (move.blue_flags & (1 << i))
+			{
+				auto const neighbor = State::Board::neighbors[move.to][i];
+				remove(accumulator, neighbor, Cell::Blue);
+				add(accumulator, neighbor, player);
+			}
+		}
+	}
+
+	/// The score of a position from the perspective of the player to move
+	int evaluate(NetworkAccumulator const &accumulator, Cell turn) const
+	{
+		bool const green = turn == Cell::Green;
+		return _layers.evaluate(accumulator.perspectives[green ? 0 : 1], accumulator.perspectives[green ? 1 : 0]);
+	}
+
+	int evaluate(State const &state) const { return evaluate(refresh(state), state.turn()); }
+
+	NetworkKernels kernels() const { return _layers.kernels(); }
+
+	/// A hash of the network file, telling networks apart
+	std::uint64_t identity() const { return _identity; }
+
+  private:
+	BasicNetwork(MappedFile file, NetworkKernels kernels)
+		: _file{std::move(file)}, _layers{_file.bytes(), num_features, kernels}
+	{
+		for (std::byte byte : _file.bytes())
+		{
+			_identity ^= std::to_integer<std::uint64_t>(byte);
+			_identity = splitmix64(_identity);
+		}
+	}
+
+	/// Own pieces, then the opponent's, then blues, each cell by cell
+	static std::size_t feature(Cell perspective, Index idx, Cell cell)
+	{
+		std::size_t const kind = cell == Cell::Blue ? 2 : cell == perspective ? 0 : 1;
+		return kind * State::num_cells + idx;
+	}
+
+	MappedFile _file;
+	NetworkLayers _layers;
+	std::uint64_t _identity = 0;
+};
+
+export using Network = BasicNetwork<rows, cols>;
+
+} // namespace flit
\ No newline at end of file
@@ -0,0 +1,258 @@
+#include <catch2/catch_test_macros.hpp>
+#include <libassert/assert-catch2.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <random>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+import flit.evaluator;
+import flit.game;
+import flit.network;
+
+namespace
+{
+
+using Network = flit::BasicNetwork<6, 6>;
+using State = Network::State;
+
+/// A network file of one test and process, removed when the test ends however it ends
+struct NetworkFile
+{
+	std::string path;
+
+	explicit NetworkFile(std::string const &test)
+		: path{(std::filesystem::temp_directory_path() / std::format("flit-network-{}-{}.bin", test, ::getpid())).string()}
+	{
+	}
+
+	NetworkFile(NetworkFile const &) = delete;
+	NetworkFile &operator=(NetworkFile const &) = delete;
+
+	~NetworkFile() { std::filesystem::remove(path); }
+};
+
+flit::NetworkWeights
+empty_weights()
+{
+	return {
+		.hidden_bias = std::vector<std::int32_t>(flit::network_hidden_size),
+		.feature_bias = std::vector<std::int16_t>(flit::network_accumulator_size),
+		.feature_weights = std::vector<std::int16_t>(Network::num_features * flit::network_accumulator_size),
+		.hidden_weights = std::vector<std::int8_t>(flit::network_hidden_size * 2 * flit::network_accumulator_size),
+		.output_weights = std::vector<std::int8_t>(flit::network_hidden_size),
+	};
+}
+
+/// Counts each player's pieces in the first neuron and scores the difference like the material heuristic
+flit::NetworkWeights
+material_weights()
+{
+	flit::NetworkWeights weights = empty_weights();
+	for (std::size_t idx = 0; idx < State::num_cells; ++idx)
+	{
+		// Own pieces come first among the features
+		weights.feature_weights[idx * flit::network_accumulator_size] = 1;
+	}
+	std::size_t const them = flit::network_accumulator_size;
+	weights.hidden_weights[0] = 1 << flit::network_shift;
+	weights.hidden_weights[them] = -(1 << flit::network_shift);
+	weights.hidden_weights[2 * flit::network_accumulator_size] = -(1 << flit::network_shift);
+	weights.hidden_weights[2 * flit::network_accumulator_size + them] = 1 << flit::network_shift;
+	weights.output_weights[0] = 1;
+	weights.output_weights[1] = -1;
+	weights.output_scale = 1000 << flit::network_shift;
+	return weights;
+}
+
+flit::NetworkWeights
+random_weights(std::mt19937 &engine)
+{
+	flit::NetworkWeights weights = empty_weights();
+	std::uniform_int_distribution<int> small{-20, 20};
+	std::uniform_int_distribution<int> byte{-128, 127};
+	for (auto &w : weights.feature_weights)
+	{
+		w = static_cast<std::int16_t>(small(engine));
+	}
+	for (auto &w : weights.feature_bias)
+	{
+		w = static_cast<std::int16_t>(small(engine) * 3);
+	}
+	for (auto &w : weights.hidden_weights)
+	{
+		w = static_cast<std::int8_t>(byte(engine));
+	}
+	for (auto &w : weights.hidden_bias)
+	{
+		w = small(engine) * 64;
+	}
+	for (auto &w : weights.output_weights)
+	{
+		w = static_cast<std::int8_t>(byte(engine));
+	}
+	weights.output_bias = small(engine);
+	return weights;
+}
+
+} // namespace
+
+TEST_CASE("A material network scores like the material heuristic", "[network]")
+{
+	NetworkFile const file{"material"};
+	Network::write(file.path, material_weights());
+	Network network = Network::open(file.path, flit::NetworkKernels::Scalar);
+
+	State state{};
+	state.set(0, 0, flit::Cell::Green);
+	state.set(0, 1, flit::Cell::Green);
+	state.set(0, 2, flit::Cell::Green);
+	state.set(3, 3, flit::Cell::Purple);
+	state.set(3, 4, flit::Cell::Purple);
+	state.set(5, 5, flit::Cell::Blue);
+	state.turn(flit::Cell::Green);
+	ASSERT(network.evaluate(state) == 1000);
+	state.turn(flit::Cell::Purple);
+	ASSERT(network.evaluate(state) == -1000);
+}
+
+TEST_CASE("Network updates match a refresh and the kernels agree", "[network]")
+{
+	std::mt19937 engine{7};
+	NetworkFile const file{"random"};
+	Network::write(file.path, random_weights(engine));
+	Network network = Network::open(file.path);
+	Network scalar = Network::open(file.path, flit::NetworkKernels::Scalar);
+	INFO((network.kernels() == flit::NetworkKernels::Avx2 ? "avx2" : "scalar"));
+
+	State state{};
+	state.set(2, 2, flit::Cell::Green);
+	state.set(3, 2, flit::Cell::Green);
+	state.set(0, 4, flit::Cell::Purple);
+	state.set(0, 5, flit::Cell::Purple);
+	state.set(5, 2, flit::Cell::Blue);
+	state.turn(flit::Cell::Green);
+	flit::NetworkAccumulator accumulator = network.refresh(state);
+	for (int ply = 0; ply < 40 and state.winner() == flit::Cell::Empty; ++ply)
+	{
+		std::vector moves = state.get_legal_moves() | std::ranges::to<std::vector>();
+		if (moves.empty())
+		{
+			break;
+		}
+		auto move = moves[engine() % moves.size()];
+		network.commit(accumulator, state, move);
+		state.commit(move);
+		if (auto spawn = state.maybe_spawn_blue(engine))
+		{
+			network.add(accumulator, *spawn, flit::Cell::Blue);
+		}
+		ASSERT(accumulator == network.refresh(state));
+		ASSERT(accumulator == scalar.refresh(state));
+		ASSERT(network.evaluate(accumulator, state.turn()) == scalar.evaluate(accumulator, state.turn()));
+	}
+}
+
+TEST_CASE("Solver evaluates with the network in place of the heuristic", "[network]")
+{
+	NetworkFile const file{"solver"};
+	// Pieces are worth other than to the heuristic, so that its scores cannot pass for the network's
+	flit::NetworkWeights weights = material_weights();
+	weights.output_scale = 700 << flit::network_shift;
+	Network::write(file.path, weights);
+	auto network = std::make_shared<Network const>(Network::open(file.path));
+
+	State state{};
+	state.set(2, 2, flit::Cell::Green);
+	state.set(3, 2, flit::Cell::Green);
+	state.set(5, 2, flit::Cell::Blue);
+	state.set(0, 4, flit::Cell::Purple);
+	state.set(0, 5, flit::Cell::Purple);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	std::size_t const move_count = std::ranges::distance(state.get_legal_moves());
+	flit::BasicSolver<6, 6> solver{state, 1 << 16, {.quiescence = false, .multipv = static_cast<int>(move_count)}};
+	solver.network(network);
+	auto results = solver.solve(flit::Cell::Green, 0);
+	// A spawned blue changes no material, so every move scores the material it leaves behind
+	REQUIRE(results.size() == move_count);
+	for (auto const &result : results)
+	{
+		State child = state;
+		child.commit(result.move);
+		INFO(std::format("{}", result.move));
+		ASSERT(result.score == 700 * (child.green_count() - child.purple_count()));
+	}
+}
+
+TEST_CASE("Spawns are not collapsed when evaluating with a network", "[network]")
+{
+	NetworkFile const file{"collapse"};
+	Network::write(file.path, material_weights());
+	auto network = std::make_shared<Network const>(Network::open(file.path));
+
+	State state{};
+	state.set(0, 0, flit::Cell::Green);
+	state.set(0, 1, flit::Cell::Green);
+	state.set(1, 4, flit::Cell::Purple);
+	state.set(1, 5, flit::Cell::Purple);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	flit::BasicSolver<6, 6> heuristic{state, 1 << 16};
+	heuristic.solve(flit::Cell::Green, 1);
+	ASSERT(heuristic.stats().collapsed_spawns > 0);
+	flit::BasicSolver<6, 6> solver{state, 1 << 16};
+	solver.network(network);
+	solver.solve(flit::Cell::Green, 1);
+	// Every blue is an input of the network, however far from the pieces
+	ASSERT(solver.stats().collapsed_spawns == 0);
+}
+
+TEST_CASE("Switching the evaluator empties the transposition table", "[network]")
+{
+	NetworkFile const file{"switch"};
+	std::mt19937 engine{3};
+	Network::write(file.path, random_weights(engine));
+	auto network = std::make_shared<Network const>(Network::open(file.path));
+
+	State state{};
+	state.set(2, 2, flit::Cell::Green);
+	state.set(3, 2, flit::Cell::Green);
+	state.set(5, 2, flit::Cell::Blue);
+	state.set(0, 4, flit::Cell::Purple);
+	state.set(0, 5, flit::Cell::Purple);
+	state.turn(flit::Cell::Green);
+
+	flit::BasicSolver<6, 6> switched{state, 1 << 16};
+	switched.solve(flit::Cell::Green, 2);
+	switched.network(network);
+	switched.reset(state);
+	auto results = switched.solve(flit::Cell::Green, 2);
+	flit::BasicSolver<6, 6> fresh{state, 1 << 16};
+	fresh.network(network);
+	auto expected = fresh.solve(flit::Cell::Green, 2);
+	// No heuristic score is left to cut the search short
+	ASSERT(switched.stats().nodes == fresh.stats().nodes);
+	ASSERT(results[0].score == expected[0].score);
+	ASSERT(flit::BasicSolver<6, 6>::evaluator_identity(network.get())
+		   != flit::BasicSolver<6, 6>::evaluator_identity(nullptr));
+}
+
+TEST_CASE("Networks of another board size are rejected", "[network]")
+{
+	NetworkFile const file{"size"};
+	flit::NetworkWeights weights = empty_weights();
+	weights.feature_weights.resize(flit::BasicNetwork<4, 4>::num_features * flit::network_accumulator_size);
+	flit::BasicNetwork<4, 4>::write(file.path, weights);
+	REQUIRE_THROWS_AS(Network::open(file.path), std::runtime_error);
+}
\ No newline at end of file
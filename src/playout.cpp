@@ -0,0 +1,83 @@
+module;
+
+#include <chrono>
+#include <cstddef>
+#include <random>
+
+export module flit.playout;
+
+export import flit.game;
+
+namespace flit
+{
+
+export struct PlayoutResult
+{
+	/// Cell::Empty if the playout was cut off before the game ended
+	Cell winner;
+	int plies;
+};
+
+/// Plies after which a playout is cut off unless asked otherwise, as pieces can shuffle for a very long time
+export constexpr int default_playout_plies = 1000;
+
+/// Plays uniformly random moves, each followed by a spawn roll, until the game ends or `max_plies` moves were played.
+/// Does not allocate.
+export template <std::uniform_random_bit_generator Engine>
+PlayoutResult
+random_playout(GameState &state, Engine &engine, int max_plies = default_playout_plies)
+{
+	for (int ply = 0; ply < max_plies; ++ply)
+	{
+		if (state.green_count() >= winning_count)
+		{
+			return {Cell::Green, ply};
+		}
+		else if (state.purple_count() >= winning_count)
+		{
+			return {Cell::Purple, ply};
+		}
+		auto move = state.random_legal_move(engine);
+		if (not move)
+		{
+			return {opponent(state.turn()), ply};
+		}
+		state.commit(*move);
+		state.maybe_spawn_blue(engine);
+	}
+	return {state.winner(), max_plies};
+}
+
+export struct PlayoutThroughput
+{
+	std::size_t playouts = 0;
+	std::size_t plies = 0;
+	std::chrono::nanoseconds time{};
+
+	double playouts_per_second() const
+	{
+		return static_cast<double>(playouts) / std::chrono::duration<double>(time).count();
+	}
+	double plies_per_second() const { return static_cast<double>(plies) / std::chrono::duration<double>(time).count(); }
+};
+
+/// Repeats playouts from a position for the given duration
+export template <std::uniform_random_bit_generator Engine>
+PlayoutThroughput
+measure_playouts(GameState const &start, Engine &engine, std::chrono::nanoseconds duration, int max_plies)
+{
+	PlayoutThroughput result;
+	auto begin = std::chrono::steady_clock::now();
+	auto end = begin;
+	while (end - begin < duration)
+	{
+		GameState state = start;
+		result.plies += random_playout(state, engine, max_plies).plies;
+		++result.playouts;
+		end = std::chrono::steady_clock::now();
+	}
+	result.time = end - begin;
+	return result;
+}
+
+} // namespace flit
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include <catch2/catch_test_macros.hpp>
+#include <libassert/assert-catch2.hpp>
+
+#include <format>
+#include <map>
+#include <random>
+#include <ranges>
+#include <utility>
+#include <vector>
+
+import flit.game;
+import flit.playout;
+
+TEST_CASE("Random legal moves are uniform over the legal moves", "[playout]")
+{
+	flit::GameState state{};
+	state.set(4, 5, flit::Cell::Green);
+	state.set(5, 5, flit::Cell::Green);
+	state.set(5, 7, flit::Cell::Green);
+	state.set(6, 6, flit::Cell::Blue);
+	state.set(0, 0, flit::Cell::Purple);
+	state.set(0, 1, flit::Cell::Purple);
+	state.turn(flit::Cell::Green);
+	INFO(flit::dump(state));
+
+	std::vector legal_moves = state.get_legal_moves() | std::ranges::to<std::vector>();
+	std::map<std::pair<int, int>, int> counts;
+	for (flit::Move move : legal_moves)
+	{
+		counts[{move.from, move.to}] = 0;
+	}
+
+	constexpr int samples_per_move = 2000;
+	std::mt19937 engine{1};
+	for (std::size_t i = 0; i < samples_per_move * legal_moves.size(); ++i)
+	{
+		auto move = state.random_legal_move(engine);
+		ASSERT(move.has_value());
+		ASSERT(std::ranges::contains(legal_moves, *move));
+		++counts[{move->from, move->to}];
+	}
+	ASSERT(counts.size() == legal_moves.size());
+	for (auto [move, count] : counts)
+	{
+		ASSERT(count > samples_per_move * 8 / 10);
+		ASSERT(count < samples_per_move * 12 / 10);
+	}
+}
+
+TEST_CASE("Random legal move is empty without legal moves", "[playout]")
+{
+	flit::GameState state{};
+	state.set(5, 5, flit::Cell::Green);
+	state.turn(flit::Cell::Green);
+	std::mt19937 engine{1};
+	ASSERT(not state.random_legal_move(engine).has_value());
+}
+
+TEST_CASE("Playouts run until the game is decided", "[playout]")
+{
+	std::mt19937 engine{1};
+	for (int i = 0; i < 10; ++i)
+	{
+		flit::GameState state = flit::random_start(engine);
+		flit::PlayoutResult result = flit::random_playout(state, engine);
+		ASSERT(result.winner != flit::Cell::Empty);
+		ASSERT(result.winner == state.winner());
+		ASSERT(result.plies < flit::default_playout_plies);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,203 @@
+module;
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+export module flit.position_batch;
+
+import flit.game;
+
+namespace flit
+{
+
+/// Positions of one board size stored cell by cell, one byte per position, so that a 128-bit register holds a cell
+/// of every position and the move generation of all of them runs as one instruction stream
+export template <std::uint_fast8_t Rows, std::uint_fast8_t Cols>
+class BasicPositionBatch
+{
+  public:
+	using State = BasicGameState<Rows, Cols>;
+	using Board = State::Board;
+	using Index = State::Index;
+	static constexpr std::size_t num_cells = State::num_cells;
+	/// Positions in a batch, one per byte lane
+	static constexpr std::size_t lanes = 16;
+	/// One bit per lane, lane i at bit i
+	using LaneMask = std::uint16_t;
+
+	struct Moves
+	{
+		/// Per cell, the lanes in which the player to move has a legal move to it
+		std::array<LaneMask, num_cells> targets;
+		/// Per cell, the lanes in which a blue may spawn on it
+		std::array<LaneMask, num_cells> spawns;
+		/// Legal moves of the player to move in every lane
+		std::array<int, lanes> move_counts;
+
+		std::bitset<num_cells> lane_targets(std::size_t lane) const { return gather(targets, lane); }
+		std::bitset<num_cells> lane_spawns(std::size_t lane) const { return gather(spawns, lane); }
+	};
+
+	/// A batch of empty boards with green to move
+	BasicPositionBatch() { _turn.fill(std::to_underlying(Cell::Green)); }
+
+	void set(std::size_t lane, State const &state)
+	{
+		for (std::size_t idx = 0; idx < num_cells; ++idx)
+		{
+			_cells[idx][lane] = std::to_underlying(state.get(static_cast<Index>(idx)));
+		}
+		_turn[lane] = std::to_underlying(state.turn());
+	}
+
+	/// The moves of every lane, with SSE2 where the target has it
+	Moves moves() const
+	{
+#if defined(__SSE2__)
+		if constexpr (num_cells < 256)
+		{
+			return moves_sse2();
+		}
+#endif
+		return moves_scalar();
+	}
+
+	/// The moves of every lane, one lane at a time
+	Moves moves_scalar() const
+	{
+		Moves result{};
+		for (std::size_t lane = 0; lane < lanes; ++lane)
+		{
+			auto const bit = static_cast<LaneMask>(1u << lane);
+			std::uint8_t const turn = _turn[lane];
+			int player_count = 0;
+			for (std::size_t idx = 0; idx < num_cells; ++idx)
+			{
+				player_count += _cells[idx][lane] == turn;
+			}
+			int targets = 0;
+			int single_cover_targets = 0;
+			for (std::size_t target = 0; target < num_cells; ++target)
+			{
+				if (_cells[target][lane] != std::to_underlying(Cell::Empty))
+				{
+					continue;
+				}
+				int cover = 0;
+				bool spawn = true;
+				for (auto neighbor : Board::neighbors[target])
+				{
+					cover += _cells[neighbor][lane] == turn;
+					spawn = spawn and _cells[neighbor][lane] == std::to_underlying(Cell::Empty);
+				}
+				if (spawn)
+				{
+					result.spawns[target] |= bit;
+				}
+				// With a single piece the only piece covering a target is also the only one that could move there
+				if (cover > 0 and player_count >= 2)
+				{
+					result.targets[target] |= bit;
+					++targets;
+					single_cover_targets += cover == 1;
+				}
+			}
+			result.move_counts[lane] = player_count * targets - single_cover_targets;
+		}
+		return result;
+	}
+
+#if defined(__SSE2__)
+	/// The moves of every lane, a cell of all lanes at a time. Counts are kept in bytes, so boards have fewer than 256
+	/// cells.
+	Moves moves_sse2() const
+	{
+		static_assert(num_cells < 256);
+		Moves result{};
+		__m128i const zero = _mm_setzero_si128();
+		__m128i const one = _mm_set1_epi8(1);
+		__m128i const two = _mm_set1_epi8(2);
+		__m128i const turn = load(_turn);
+
+		// All-ones bytes where the cell holds a piece of the player to move, or nothing
+		__m128i own[num_cells];
+		__m128i empty[num_cells];
+		__m128i player_count = zero;
+		for (std::size_t idx = 0; idx < num_cells; ++idx)
+		{
+			__m128i const cell = load(_cells[idx]);
+			own[idx] = _mm_cmpeq_epi8(cell, turn);
+			empty[idx] = _mm_cmpeq_epi8(cell, zero);
+			player_count = _mm_sub_epi8(player_count, own[idx]);
+		}
+		// Unsigned comparison, as a board may hold more than 127 pieces
+		__m128i const has_moves = _mm_cmpeq_epi8(_mm_max_epu8(player_count, two), player_count);
+
+		// Counts stay below 256, as every one of the fewer than 256 cells is counted at most once
+		__m128i targets = zero;
+		__m128i single_cover_targets = zero;
+		for (std::size_t target = 0; target < num_cells; ++target)
+		{
+			auto const &neighbors = Board::neighbors[target];
+			__m128i cover = zero;
+			__m128i spawn = empty[target];
+			for (auto neighbor : neighbors)
+			{
+				cover = _mm_sub_epi8(cover, own[neighbor]);
+				spawn = _mm_and_si128(spawn, empty[neighbor]);
+			}
+			__m128i const legal
+				= _mm_and_si128(_mm_andnot_si128(_mm_cmpeq_epi8(cover, zero), empty[target]), has_moves);
+			targets = _mm_sub_epi8(targets, legal);
+			single_cover_targets = _mm_sub_epi8(single_cover_targets, _mm_and_si128(legal, _mm_cmpeq_epi8(cover, one)));
+			result.targets[target] = static_cast<LaneMask>(_mm_movemask_epi8(legal));
+			result.spawns[target] = static_cast<LaneMask>(_mm_movemask_epi8(spawn));
+		}
+
+		alignas(16) std::array<std::uint8_t, lanes> player_counts;
+		alignas(16) std::array<std::uint8_t, lanes> target_counts;
+		alignas(16) std::array<std::uint8_t, lanes> single_counts;
+		_mm_store_si128(reinterpret_cast<__m128i *>(player_counts.data()), player_count);
+		_mm_store_si128(reinterpret_cast<__m128i *>(target_counts.data()), targets);
+		_mm_store_si128(reinterpret_cast<__m128i *>(single_counts.data()), single_cover_targets);
+		for (std::size_t lane = 0; lane < lanes; ++lane)
+		{
+			result.move_counts[lane] = player_counts[lane] * target_counts[lane] - single_counts[lane];
+		}
+		return result;
+	}
+#endif
+
+  private:
+	static std::bitset<num_cells> gather(std::array<LaneMask, num_cells> const &masks, std::size_t lane)
+	{
+		std::bitset<num_cells> result;
+		for (std::size_t idx = 0; idx < num_cells; ++idx)
+		{
+			result[idx] = (masks[idx] >> lane) & 1;
+		}
+		return result;
+	}
+
+#if defined(__SSE2__)
+	static __m128i load(std::array<std::uint8_t, lanes> const &bytes)
+	{
+		return _mm_load_si128(reinterpret_cast<__m128i const *>(bytes.data()));
+	}
+#endif
+
+	/// The piece on every cell, as a Cell value per lane
+	alignas(16) std::array<std::array<std::uint8_t, lanes>, num_cells> _cells{};
+	alignas(16) std::array<std::uint8_t, lanes> _turn;
+};
+
+export using PositionBatch = BasicPositionBatch<rows, cols>;
+
+} // namespace flit
\ No newline at end of file
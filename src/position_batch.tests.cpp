@@ -0,0 +1,138 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <libassert/assert-catch2.hpp>
+
+#include <bitset>
+#include <cstddef>
+#include <random>
+#include <ranges>
+#include <vector>
+
+import flit.game;
+import flit.position_batch;
+
+namespace
+{
+
+/// Positions after a few random moves and spawns from random starts
+template <typename State>
+std::vector<State>
+random_positions(std::size_t count, int plies, std::mt19937 &engine)
+{
+	std::vector<State> positions;
+	while (positions.size() < count)
+	{
+		State state = flit::random_start<State>(engine);
+		for (int ply = 0; ply < plies and state.winner() == flit::Cell::Empty; ++ply)
+		{
+			state.commit(*state.random_legal_move(engine));
+			state.maybe_spawn_blue(engine);
+		}
+		positions.push_back(state);
+	}
+	return positions;
+}
+
+template <typename Batch>
+void
+check_batch(std::vector<typename Batch::State> const &positions)
+{
+	using State = Batch::State;
+	Batch batch;
+	for (auto [lane, state] : positions | std::views::enumerate)
+	{
+		batch.set(lane, state);
+	}
+	auto const moves = batch.moves();
+	auto const scalar = batch.moves_scalar();
+	ASSERT(moves.targets == scalar.targets);
+	ASSERT(moves.spawns == scalar.spawns);
+	ASSERT(moves.move_counts == scalar.move_counts);
+	for (auto [lane, state] : positions | std::views::enumerate)
+	{
+		std::bitset<State::num_cells> targets;
+		int count = 0;
+		for (auto move : state.get_legal_moves())
+		{
+			targets.set(move.to);
+			++count;
+		}
+		std::bitset<State::num_cells> spawns;
+		for (auto idx : state.get_possible_spawns())
+		{
+			spawns.set(idx);
+		}
+		ASSERT(moves.lane_targets(lane) == targets);
+		ASSERT(moves.lane_spawns(lane) == spawns);
+		ASSERT(moves.move_counts[lane] == count);
+	}
+}
+
+} // namespace
+
+TEST_CASE("Batched move generation agrees with each position's own", "[position_batch]")
+{
+	std::mt19937 engine{3};
+	for (int plies : {0, 10, 40})
+	{
+		check_batch<flit::PositionBatch>(random_positions<flit::GameState>(flit::PositionBatch::lanes, plies, engine));
+	}
+	using SmallBatch = flit::BasicPositionBatch<6, 6>;
+	check_batch<SmallBatch>(random_positions<SmallBatch::State>(SmallBatch::lanes, 10, engine));
+}
+
+TEST_CASE("Lanes of a partly filled batch hold empty boards", "[position_batch]")
+{
+	flit::GameState state{};
+	state.set(0, 0, flit::Cell::Green);
+	state.set(0, 1, flit::Cell::Green);
+	state.turn(flit::Cell::Green);
+	flit::PositionBatch batch;
+	batch.set(3, state);
+	auto moves = batch.moves();
+	ASSERT(moves.move_counts[3] == state.count_moves());
+	ASSERT(moves.move_counts[0] == 0);
+	ASSERT(moves.lane_targets(0).none());
+	ASSERT(moves.lane_spawns(0).all());
+}
+
+TEST_CASE("Batched move generation throughput", "[.benchmark][position_batch]")
+{
+	std::mt19937 engine{1};
+	auto positions = random_positions<flit::GameState>(flit::PositionBatch::lanes, 20, engine);
+
+	BENCHMARK("Legal moves of 16 positions, one at a time")
+	{
+		int count = 0;
+		for (auto const &state : positions)
+		{
+			count += static_cast<int>(std::ranges::distance(state.get_legal_moves()));
+		}
+		return count;
+	};
+	BENCHMARK("Move counts of 16 positions, one at a time")
+	{
+		int count = 0;
+		for (auto const &state : positions)
+		{
+			count += state.count_moves();
+		}
+		return count;
+	};
+	BENCHMARK("Batched moves of 16 positions, including the transposition")
+	{
+		flit::PositionBatch batch;
+		for (auto [lane, state] : positions | std::views::enumerate)
+		{
+			batch.set(lane, state);
+		}
+		return batch.moves().move_counts[0];
+	};
+	flit::PositionBatch batch;
+	for (auto [lane, state] : positions | std::views::enumerate)
+	{
+		batch.set(lane, state);
+	}
+	BENCHMARK("Batched moves of 16 positions, SSE2") { return batch.moves().move_counts[0]; };
+	BENCHMARK("Batched moves of 16 positions, scalar") { return batch.moves_scalar().move_counts[0]; };
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+
+export module flit.positions;
+
+export import flit.game;
+
+namespace flit
+{
+
+/// A position together with optional training labels
+export struct PositionRecord
+{
+	GameState state;
+	/// Search score from the perspective of the player to move
+	std::int32_t score = 0;
+	/// Final result from the perspective of the player to move: 1 for a win, -1 for a loss, 0 if unknown
+	std::int8_t result = 0;
+};
+
+export constexpr std::array<char, 4> position_file_magic{'F', 'L', 'T', 'P'};
+export constexpr std::uint8_t position_file_version = 1;
+
+namespace
+{
+
+constexpr std::size_t header_size = 8;
+/// Two bits per cell, then turn, result and a little-endian score
+constexpr std::size_t packed_board_size = (rows * cols + 3) / 4;
+constexpr std::size_t record_size = packed_board_size + 2 + 4;
+
+} // namespace
+
+/// Writes position records in the binary position format
+export class PositionWriter
+{
+  public:
+	explicit PositionWriter(std::ostream &out) : _out{out}
+	{
+		std::array<char, header_size> header{};
+		std::ranges::copy(position_file_magic, header.begin());
+		header[4] = static_cast<char>(position_file_version);
+		header[5] = static_cast<char>(rows);
+		header[6] = static_cast<char>(cols);
+		_out.write(header.data(), header.size());
+	}
+
+	void write(PositionRecord const &record)
+	{
+		std::array<char, record_size> buffer{};
+		for (std::uint_fast8_t row = 0; row < rows; ++row)
+		{
+			for (std::uint_fast8_t col = 0; col < cols; ++col)
+			{
+				std::size_t idx = from_rc(row, col);
+				buffer[idx / 4] |= static_cast<char>(std::to_underlying(record.state.get(row, col)) << (idx % 4 * 2));
+			}
+		}
+		buffer[packed_board_size] = static_cast<char>(std::to_underlying(record.state.turn()));
+		buffer[packed_board_size + 1] = static_cast<char>(record.result);
+		auto score = std::bit_cast<std::uint32_t>(record.score);
+		for (std::size_t i = 0; i < 4; ++i)
+		{
+			buffer[packed_board_size + 2 + i] = static_cast<char>(score >> (i * 8));
+		}
+		_out.write(buffer.data(), buffer.size());
+		if (not _out)
+		{
+			throw std::runtime_error{"Could not write position"};
+		}
+	}
+
+  private:
+	std::ostream &_out;
+};
+
+/// Reads position records in the binary position format
+export class PositionReader
+{
+  public:
+	explicit PositionReader(std::istream &in) : _in{in}
+	{
+		std::array<char, header_size> header{};
+		_in.read(header.data(), header.size());
+		if (not _in or not std::ranges::equal(header | std::views::take(4), position_file_magic))
+		{
+			throw std::runtime_error{"Not a position file"};
+		}
+		if (static_cast<std::uint8_t>(header[4]) != position_file_version)
+		{
+			throw std::runtime_error{"Unsupported position file version"};
+		}
+		if (static_cast<std::uint8_t>(header[5]) != rows or static_cast<std::uint8_t>(header[6]) != cols)
+		{
+			throw std::runtime_error{"Position file board size does not match"};
+		}
+	}
+
+	std::optional<PositionRecord> read()
+	{
+		std::array<char, record_size> buffer;
+		_in.read(buffer.data(), buffer.size());
+		if (_in.gcount() == 0)
+		{
+			return std::nullopt;
+		}
+		else if (static_cast<std::size_t>(_in.gcount()) != buffer.size())
+		{
+			throw std::runtime_error{"Truncated position record"};
+		}
+
+		PositionRecord record;
+		for (std::uint_fast8_t row = 0; row < rows; ++row)
+		{
+			for (std::uint_fast8_t col = 0; col < cols; ++col)
+			{
+				std::size_t idx = from_rc(row, col);
+				auto cell = static_cast<Cell>((static_cast<std::uint8_t>(buffer[idx / 4]) >> (idx % 4 * 2)) & 0b11);
+				if (cell != Cell::Empty)
+				{
+					record.state.set(row, col, cell);
+				}
+			}
+		}
+		auto turn = static_cast<Cell>(buffer[packed_board_size]);
+		if (turn != Cell::Green and turn != Cell::Purple)
+		{
+			throw std::runtime_error{"Invalid player to move"};
+		}
+		record.state.turn(turn);
+		record.result = static_cast<std::int8_t>(buffer[packed_board_size + 1]);
+		std::uint32_t score = 0;
+		for (std::size_t i = 0; i < 4; ++i)
+		{
+			score |= std::uint32_t{static_cast<std::uint8_t>(buffer[packed_board_size + 2 + i])} << (i * 8);
+		}
+		record.score = std::bit_cast<std::int32_t>(score);
+		return record;
+	}
+
+  private:
+	std::istream &_in;
+};
+
+} // namespace flit
\ No newline at end of file
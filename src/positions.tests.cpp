@@ -0,0 +1,43 @@
+#include <catch2/catch_test_macros.hpp>
+#include <libassert/assert-catch2.hpp>
+
+#include <sstream>
+
+import flit.game;
+import flit.positions;
+
+TEST_CASE("Position records survive a round trip", "[positions]")
+{
+	flit::PositionRecord record{};
+	record.state.set(4, 5, flit::Cell::Green);
+	record.state.set(5, 5, flit::Cell::Green);
+	record.state.set(7, 5, flit::Cell::Blue);
+	record.state.set(11, 11, flit::Cell::Purple);
+	record.state.turn(flit::Cell::Purple);
+	record.score = -1234;
+	record.result = -1;
+	INFO(flit::dump(record.state));
+
+	std::stringstream stream;
+	flit::PositionWriter writer{stream};
+	writer.write(record);
+	writer.write(record);
+
+	flit::PositionReader reader{stream};
+	for (int i = 0; i < 2; ++i)
+	{
+		auto read = reader.read();
+		ASSERT(read.has_value());
+		ASSERT(read->state.hash() == record.state.hash());
+		ASSERT(read->state.turn() == flit::Cell::Purple);
+		ASSERT(read->score == -1234);
+		ASSERT(read->result == -1);
+	}
+	ASSERT(not reader.read().has_value());
+}
+
+TEST_CASE("Position reader rejects other files", "[positions]")
+{
+	std::stringstream stream{"not a position file"};
+	CHECK_THROWS(flit::PositionReader{stream});
+}
\ No newline at end of file
@@ -1,11 +1,16 @@
 module;
 
+#include <algorithm>
 #include <chrono>
+#include <format>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <print>
 #include <random>
+#include <ranges>
 #include <stdexcept>
 #include <string>
 
@@ -126,6 +131,9 @@ class Repl
 			{"set", &Repl::set},
 			{"eval", &Repl::eval},
 			{"load", &Repl::load},
+			{"option", &Repl::option},
+			{"moves", &Repl::moves},
+			{"network", &Repl::network},
 		};
 
 		_tokenizer = {line};
@@ -179,11 +187,108 @@ class Repl
 	{
 		Cell color = _tokenizer.read_color();
 		int depth = _tokenizer.read_int();
-		Solver solver{_state};
+		Solver solver{_state, Solver::transposition_table_entries(_transposition_table_megabytes), _search_options};
+		solver.network(_network);
 		std::println("Move : Evaluation");
-		for (auto [move, score] : solver.solve(color, depth))
+		// Only the best `multipv` moves are searched with a full window; the rest are proven no better
+		for (auto [i, result] : solver.solve(color, depth) | std::views::enumerate)
 		{
-			std::println("{} : {}", move, score);
+			if (i < _search_options.multipv)
+			{
+				std::string line;
+				for (Move move : solver.principal_variation(result.move, depth + 1))
+				{
+					std::format_to(std::back_inserter(line), " {}", move);
+				}
+				std::println("{} : {} (pv{})", result.move, result.score, line);
+			}
+			else
+			{
+				std::println("{} : <= {}", result.move, result.score);
+			}
+		}
+		SearchStats const &stats = solver.stats();
+		std::println("Evaluated nodes: {} ({} leaves)", stats.nodes, stats.leaf_nodes);
+		std::println(
+			"Transposition table hits: {} ({:.2f}%)",
+			stats.transposition_table_hits,
+			100.0 * static_cast<double>(stats.transposition_table_hits) / static_cast<double>(stats.nodes));
+		if (stats.enhanced_cutoffs > 0)
+		{
+			std::println("Enhanced transposition cutoffs: {}", stats.enhanced_cutoffs);
+		}
+		std::println(
+			"Evaluation cache hits: {} of {} ({:.2f}%)",
+			stats.evaluation_cache_hits,
+			stats.evaluations,
+			100.0 * static_cast<double>(stats.evaluation_cache_hits)
+				/ static_cast<double>(std::max<std::size_t>(1, stats.evaluations)));
+		if (_search_options.quiescence)
+		{
+			std::println("Quiescence nodes: {}", stats.quiescence_nodes);
+		}
+		if (stats.collapsed_spawns > 0)
+		{
+			std::println("Spawns out of reach collapsed: {}", stats.collapsed_spawns);
+		}
+		if (stats.repetitions > 0)
+		{
+			std::println("Repetitions: {}", stats.repetitions);
+		}
+		if (_search_options.late_move_reductions or _search_options.futility_pruning)
+		{
+			std::println(
+				"Reductions: {} ({} re-searched), futility prunes: {}",
+				stats.reductions,
+				stats.reduction_re_searches,
+				stats.futility_prunes);
+		}
+	}
+
+	/// Prints the branching factor of a player, and how many of the moves lose cover differently
+	void moves()
+	{
+		GameState state = _state;
+		state.turn(_tokenizer.read_color());
+		std::println(
+			"Moves: {}, targets: {}, source effects: {}",
+			state.count_moves(),
+			std::ranges::distance(state.targets()),
+			state.count_source_effects());
+	}
+
+	/// Toggles the selective search techniques, e.g. `option lmr 1` or `option futility-margin 300`,
+	/// and sizes the transposition table, e.g. `option hash 256` for 256 MB
+	void option()
+	{
+		auto name = _tokenizer.read_word();
+		int value = _tokenizer.read_int();
+		if (name == "hash")
+		{
+			if (value <= 0)
+			{
+				throw std::runtime_error{"Invalid value"};
+			}
+			_transposition_table_megabytes = value;
+		}
+		else if (not set_search_option(_search_options, name, value))
+		{
+			throw std::runtime_error{"Invalid option"};
+		}
+	}
+
+	/// Evaluates with the network in the given file, e.g. `network flit.nnue`, or with the heuristic after
+	/// `network off`
+	void network()
+	{
+		auto path = _tokenizer.read_word();
+		if (path == "off")
+		{
+			_network.reset();
+		}
+		else
+		{
+			_network = std::make_shared<Network const>(Network::open(std::string{path}));
 		}
 	}
 
@@ -204,6 +309,9 @@ class Repl
 
 	Tokenizer _tokenizer;
 	GameState _state;
+	SearchOptions _search_options;
+	std::size_t _transposition_table_megabytes = 768;
+	std::shared_ptr<Network const> _network;
 	std::mt19937 _gen;
 };
 
@@ -0,0 +1,269 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <print>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+export module flit.retrograde;
+
+import flit.game;
+import flit.mapped_file;
+
+namespace flit
+{
+
+export constexpr std::array<char, 4> retrograde_file_magic{'F', 'L', 'T', 'R'};
+export constexpr std::uint8_t retrograde_file_version = 1;
+
+namespace
+{
+
+constexpr std::size_t retrograde_header_size = 8;
+
+} // namespace
+
+/// Exact values of every position of a small board, stored on disk and memory mapped.
+/// A position's value is the probability that green wins when green plays to win and purple plays to stop it,
+/// with blue spawns as chance events. Play that never ends is not a win.
+export template <std::uint_fast8_t Rows, std::uint_fast8_t Cols>
+class RetrogradeTable
+{
+  public:
+	using State = BasicGameState<Rows, Cols>;
+	static constexpr std::size_t num_cells = State::num_cells;
+	static_assert(num_cells <= 12, "The table of larger boards does not fit in memory");
+	/// Positions in the perfect index: two bits per cell and one for the player to move
+	static constexpr std::size_t size = std::size_t{2} << (2 * num_cells);
+	/// Fixed-point value of a certain green win
+	static constexpr std::uint16_t one = 0xffff;
+
+	/// Creates an unsolved table in which every value is zero
+	static RetrogradeTable create(std::string const &path)
+	{
+		MappedFile file = MappedFile::create(path, retrograde_header_size + size * sizeof(std::uint16_t));
+		std::span<std::byte> bytes = file.writable_bytes();
+		std::ranges::fill(bytes, std::byte{0});
+		std::array<char, retrograde_header_size> header{};
+		std::ranges::copy(retrograde_file_magic, header.begin());
+		header[4] = static_cast<char>(retrograde_file_version);
+		header[5] = static_cast<char>(Rows);
+		header[6] = static_cast<char>(Cols);
+		std::memcpy(bytes.data(), header.data(), header.size());
+		return RetrogradeTable{std::move(file)};
+	}
+
+	/// Opens a table for reading, checking that it belongs to this board size
+	static RetrogradeTable open(std::string const &path)
+	{
+		MappedFile file = MappedFile::open(path);
+		std::span<std::byte const> bytes = file.bytes();
+		if (bytes.size() != retrograde_header_size + size * sizeof(std::uint16_t)
+			or std::memcmp(bytes.data(), retrograde_file_magic.data(), retrograde_file_magic.size()) != 0
+			or static_cast<std::uint8_t>(bytes[4]) != retrograde_file_version
+			or static_cast<std::uint8_t>(bytes[5]) != Rows or static_cast<std::uint8_t>(bytes[6]) != Cols)
+		{
+			throw std::runtime_error{"Not a retrograde table of this board size"};
+		}
+		return RetrogradeTable{std::move(file)};
+	}
+
+	static std::size_t index(State const &state)
+	{
+		std::size_t result = state.turn() == Cell::Purple;
+		for (std::size_t idx = 0; idx < num_cells; ++idx)
+		{
+			result |= std::size_t{std::to_underlying(state.get(static_cast<typename State::Index>(idx)))} << (1 + 2 * idx);
+		}
+		return result;
+	}
+
+	static State state(std::size_t index)
+	{
+		State result;
+		for (std::size_t idx = 0; idx < num_cells; ++idx)
+		{
+			if (Cell cell = static_cast<Cell>((index >> (1 + 2 * idx)) & 0b11); cell != Cell::Empty)
+			{
+				result.set(static_cast<typename State::Index>(idx), cell);
+			}
+		}
+		result.turn(index & 1 ? Cell::Purple : Cell::Green);
+		return result;
+	}
+
+	std::uint16_t value(std::size_t index) const
+	{
+		// Values being solved change under other threads
+		return _writable_values ? std::atomic_ref{_writable_values[index]}.load(std::memory_order_relaxed)
+								: _values[index];
+	}
+
+	double green_win_probability(State const &state) const { return static_cast<double>(value(index(state))) / one; }
+
+	/// Value iteration from below until no value changes, sweeping the positions in parallel.
+	/// Values only ever grow, so threads may update them in place. Returns the number of sweeps.
+	int solve(unsigned threads, int max_sweeps)
+	{
+		if (not _writable_values)
+		{
+			throw std::runtime_error{"Only newly created tables can be solved"};
+		}
+		constexpr std::size_t chunk_size = 1 << 14;
+		int sweep = 0;
+		while (sweep < max_sweeps)
+		{
+			auto begin = std::chrono::steady_clock::now();
+			std::atomic<std::size_t> next_chunk = 0;
+			std::atomic<std::size_t> changed = 0;
+			{
+				std::vector<std::jthread> workers;
+				for (unsigned i = 0; i < threads; ++i)
+				{
+					workers.emplace_back(
+						[&]
+						{
+							std::size_t local_changed = 0;
+							for (std::size_t chunk = next_chunk++; chunk * chunk_size < size; chunk = next_chunk++)
+							{
+								std::size_t const end = std::min(size, (chunk + 1) * chunk_size);
+								for (std::size_t index = chunk * chunk_size; index < end; ++index)
+								{
+									std::uint16_t const updated = evaluate(index);
+									std::atomic_ref current{_writable_values[index]};
+									if (updated > current.load(std::memory_order_relaxed))
+									{
+										current.store(updated, std::memory_order_relaxed);
+										++local_changed;
+									}
+								}
+							}
+							changed += local_changed;
+						});
+				}
+			}
+			++sweep;
+			auto end = std::chrono::steady_clock::now();
+			std::println(
+				stderr,
+				"Sweep {}: {} of {} values changed in {}",
+				sweep,
+				changed.load(),
+				size,
+				std::chrono::duration_cast<std::chrono::milliseconds>(end - begin));
+			if (changed == 0)
+			{
+				break;
+			}
+		}
+		_file.flush();
+		return sweep;
+	}
+
+  private:
+	explicit RetrogradeTable(MappedFile file)
+		: _file{std::move(file)},
+		  _values{reinterpret_cast<std::uint16_t const *>(_file.bytes().data() + retrograde_header_size)}
+	{
+		if (_file.writable())
+		{
+			_writable_values = reinterpret_cast<std::uint16_t *>(_file.writable_bytes().data() + retrograde_header_size);
+		}
+	}
+
+	/// The value of a position given the current values of its children
+	std::uint16_t evaluate(std::size_t index) const
+	{
+		State state = RetrogradeTable::state(index);
+		switch (state.winner())
+		{
+		case Cell::Green: return one;
+		case Cell::Purple: return 0;
+		default: break;
+		}
+		bool const green = state.turn() == Cell::Green;
+		double best = green ? 0.0 : 1.0;
+		for (auto move : state.get_legal_moves())
+		{
+			state.commit(move);
+			double expected = spawn_expectation(state);
+			state.uncommit(move);
+			best = green ? std::max(best, expected) : std::min(best, expected);
+		}
+		return static_cast<std::uint16_t>(best * one);
+	}
+
+	/// The expected value of a position right after a move, before the roll for a blue spawn
+	double spawn_expectation(State &state) const
+	{
+		double const no_spawn = static_cast<double>(value(index(state))) / one;
+		double spawn_total = 0;
+		int spawns = 0;
+		for (auto idx : state.get_possible_spawns())
+		{
+			state.set(idx, Cell::Blue);
+			spawn_total += static_cast<double>(value(index(state))) / one;
+			state.unset(idx);
+			++spawns;
+		}
+		if (spawns == 0)
+		{
+			return no_spawn;
+		}
+		return ((blue_spawn_odds - 1) * no_spawn + spawn_total / spawns) / blue_spawn_odds;
+	}
+
+	MappedFile _file;
+	std::uint16_t const *_values;
+	std::uint16_t *_writable_values = nullptr;
+};
+
+export struct RetrogradeOptions
+{
+	std::string output;
+	std::uint_fast8_t rows = 3;
+	std::uint_fast8_t cols = 3;
+	unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+	int max_sweeps = 1000;
+};
+
+/// Solves every position of a small board and writes the table to the output file
+export void
+build_retrograde_table(RetrogradeOptions const &options)
+{
+	auto build = [&]<std::uint_fast8_t Rows, std::uint_fast8_t Cols>
+	{
+		auto table = RetrogradeTable<Rows, Cols>::create(options.output);
+		int sweeps = table.solve(options.threads, options.max_sweeps);
+		std::println(stderr, "Solved {}x{} in {} sweeps", Rows, Cols, sweeps);
+	};
+	if (options.rows == 3 and options.cols == 3)
+	{
+		build.template operator()<3, 3>();
+	}
+	else if (options.rows == 3 and options.cols == 4)
+	{
+		build.template operator()<3, 4>();
+	}
+	else if (options.rows == 4 and options.cols == 3)
+	{
+		build.template operator()<4, 3>();
+	}
+	else
+	{
+		throw std::runtime_error{"Retrograde tables are only built for 3x3, 3x4 and 4x3 boards"};
+	}
+}
+
+} // namespace flit
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include <catch2/catch_test_macros.hpp>
+#include <libassert/assert-catch2.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <string>
+
+#include <unistd.h>
+
+import flit.game;
+import flit.evaluator;
+import flit.retrograde;
+
+namespace
+{
+
+using Table = flit::RetrogradeTable<3, 3>;
+using State = Table::State;
+
+/// Solved once and shared by the tests of a process, as solving takes a while. Every process solves into a file of
+/// its own, which is removed at once and lives on in the mapping.
+Table const &
+solved_table()
+{
+	static Table const table = []
+	{
+		std::string const path
+			= (std::filesystem::temp_directory_path() / std::format("flit-retrograde-3x3-{}.bin", ::getpid())).string();
+		Table table = Table::create(path);
+		std::filesystem::remove(path);
+		table.solve(1, 1000);
+		return table;
+	}();
+	return table;
+}
+
+} // namespace
+
+TEST_CASE("Retrograde index is a bijection", "[retrograde]")
+{
+	State state{};
+	state.set(0, 0, flit::Cell::Green);
+	state.set(1, 2, flit::Cell::Purple);
+	state.set(2, 1, flit::Cell::Blue);
+	state.turn(flit::Cell::Purple);
+	State decoded = Table::state(Table::index(state));
+	ASSERT(decoded.hash() == state.hash());
+	ASSERT(Table::index(decoded) == Table::index(state));
+}
+
+TEST_CASE("Retrograde table knows won positions", "[retrograde]")
+{
+	Table const &table = solved_table();
+
+	State won{};
+	won.set(0, 0, flit::Cell::Green);
+	won.set(0, 1, flit::Cell::Green);
+	won.set(0, 2, flit::Cell::Green);
+	won.set(2, 2, flit::Cell::Purple);
+	won.set(2, 1, flit::Cell::Purple);
+	won.turn(flit::Cell::Purple);
+	ASSERT(table.green_win_probability(won) == 1.0);
+
+	// Green captures the blue and reaches three pieces
+	State capture{};
+	capture.set(0, 0, flit::Cell::Green);
+	capture.set(1, 0, flit::Cell::Green);
+	capture.set(1, 2, flit::Cell::Blue);
+	capture.set(2, 2, flit::Cell::Purple);
+	capture.set(0, 2, flit::Cell::Purple);
+	capture.turn(flit::Cell::Green);
+	INFO(flit::dump(capture));
+	ASSERT(table.green_win_probability(capture) == 1.0);
+
+	// The heuristic search finds the winning capture as well
+	flit::BasicSolver<3, 3> solver{capture, 1 << 12};
+	auto best = solver.solve(flit::Cell::Green, 1)[0].move;
+	capture.commit(best);
+	ASSERT(capture.winner() == flit::Cell::Green);
+}
+
+TEST_CASE("Retrograde values satisfy the expectimax equations", "[retrograde]")
+{
+	Table const &table = solved_table();
+	auto value = [&](State const &state) { return table.green_win_probability(state); };
+
+	for (std::size_t index = 0; index < Table::size; index += 997)
+	{
+		State state = Table::state(index);
+		if (state.winner() != flit::Cell::Empty)
+		{
+			continue;
+		}
+		bool green = state.turn() == flit::Cell::Green;
+		double best = green ? 0.0 : 1.0;
+		for (auto move : state.get_legal_moves())
+		{
+			state.commit(move);
+			double expected = value(state);
+			double spawn_total = 0;
+			int spawns = 0;
+			for (auto idx : state.get_possible_spawns())
+			{
+				state.set(idx, flit::Cell::Blue);
+				spawn_total += value(state);
+				state.unset(idx);
+				++spawns;
+			}
+			if (spawns > 0)
+			{
+				expected = ((flit::blue_spawn_odds - 1) * expected + spawn_total / spawns) / flit::blue_spawn_odds;
+			}
+			state.uncommit(move);
+			best = green ? std::max(best, expected) : std::min(best, expected);
+		}
+		INFO(flit::dump(state));
+		ASSERT(std::abs(value(state) - best) < 1e-4);
+	}
+}
\ No newline at end of file
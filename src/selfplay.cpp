@@ -0,0 +1,238 @@
+module;
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <random>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+export module flit.selfplay;
+
+import flit.game;
+import flit.positions;
+import flit.evaluator;
+import flit.huge_pages;
+
+namespace flit
+{
+
+export struct SelfPlayOptions
+{
+	/// Shards are written to `<output>-000.bin`, `<output>-001.bin` and so on
+	std::string output;
+	std::size_t games = 1000;
+	int depth = 1;
+	unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+	unsigned shards = 16;
+	/// Position hashes each shard remembers to skip duplicates, rounded up to a power of two
+	std::size_t dedupe_size = 1 << 18;
+	/// Uniformly random moves played at the start of each game for variety
+	int random_plies = 4;
+	/// Games still running after this many plies are recorded without a result
+	int max_plies = 1000;
+	std::uint64_t seed = std::random_device{}();
+	/// Transposition table entries per worker thread, or of the shared table
+	std::size_t transposition_table_size = 1 << 22;
+	/// Name of a shared memory segment holding one transposition table for all threads and processes, if not empty
+	std::string shared_transposition_table;
+	/// File of a network evaluating positions in place of the heuristic, if not empty
+	std::string network;
+	SearchOptions search;
+};
+
+namespace
+{
+
+/// One output file, together with the hashes of the positions last written to it. The hashes sit in a fixed table
+/// indexed by their high bits, as the low ones pick the shard, so a duplicate is only missed once its hash was
+/// overwritten.
+class Shard
+{
+  public:
+	Shard(std::string const &path, std::size_t dedupe_size)
+		: _file{path, std::ios::binary}, _writer{_file}, _seen(std::bit_ceil(std::max<std::size_t>(1, dedupe_size)))
+	{
+		if (not _file)
+		{
+			throw std::runtime_error{std::format("Could not open {}", path)};
+		}
+	}
+
+	/// Writes the record unless the position was written before
+	bool write(std::uint64_t key, PositionRecord const &record)
+	{
+		std::lock_guard lock{_mutex};
+		std::uint64_t &seen = _seen[(key >> 32) & (_seen.size() - 1)];
+		if (seen == key)
+		{
+			return false;
+		}
+		seen = key;
+		_writer.write(record);
+		return true;
+	}
+
+  private:
+	std::mutex _mutex;
+	std::ofstream _file;
+	PositionWriter _writer;
+	std::vector<std::uint64_t> _seen;
+};
+
+} // namespace
+
+/// Plays games of the solver against itself, recording every searched position with
+/// its search score and the final result of the game
+export void
+self_play(SelfPlayOptions const &options)
+{
+	if (options.shards == 0)
+	{
+		throw std::runtime_error{"At least one shard is required"};
+	}
+	std::vector<std::unique_ptr<Shard>> shards;
+	for (unsigned i = 0; i < options.shards; ++i)
+	{
+		shards.push_back(std::make_unique<Shard>(std::format("{}-{:03}.bin", options.output, i), options.dedupe_size));
+	}
+
+	// Mapped once and read by every worker
+	std::shared_ptr<Network const> network;
+	if (not options.network.empty())
+	{
+		network = std::make_shared<Network const>(Network::open(options.network));
+	}
+
+	// Opened and checked once here, so that a bad segment is reported before any game starts
+	std::optional<TranspositionTable> shared_table;
+	if (not options.shared_transposition_table.empty())
+	{
+		shared_table = TranspositionTable::shared(
+			options.shared_transposition_table,
+			options.transposition_table_size,
+			Solver::evaluator_identity(network.get()));
+	}
+	std::vector<std::unique_ptr<Solver>> solvers;
+	for (unsigned i = 0; i < options.threads; ++i)
+	{
+		solvers.push_back(std::make_unique<Solver>(
+			GameState{},
+			shared_table ? shared_table->share() : TranspositionTable{options.transposition_table_size},
+			options.search));
+		solvers.back()->network(network);
+	}
+
+	std::println(stderr, "Transposition tables on {}", page_kind_name(solvers.front()->transposition_table_pages()));
+
+	std::atomic<std::size_t> next_game = 0;
+	std::atomic<std::size_t> written = 0;
+	std::atomic<std::size_t> duplicates = 0;
+	std::mutex progress_mutex;
+	// The first error of a worker, which stops the others and is rethrown once they are joined
+	std::exception_ptr error;
+
+	auto play = [&](Solver &solver, std::uint64_t seed)
+	{
+		std::mt19937_64 engine{seed};
+		std::vector<PositionRecord> records;
+
+		for (std::size_t game = next_game++; game < options.games; game = next_game++)
+		{
+			records.clear();
+			GameState state = random_start(engine);
+			Cell winner = Cell::Empty;
+			for (int ply = 0; ply < options.max_plies; ++ply)
+			{
+				if (winner = state.winner(); winner != Cell::Empty)
+				{
+					break;
+				}
+				Move move;
+				if (ply < options.random_plies)
+				{
+					std::vector moves = state.get_legal_moves() | std::ranges::to<std::vector>();
+					move = moves[std::uniform_int_distribution<std::size_t>{0, moves.size() - 1}(engine)];
+				}
+				else
+				{
+					solver.reset(state);
+					auto evaluations = solver.solve(state.turn(), options.depth);
+					records.push_back({.state = state, .score = evaluations[0].score});
+					move = evaluations[0].move;
+				}
+				state.commit(move);
+				state.maybe_spawn_blue(engine);
+			}
+
+			for (PositionRecord &record : records)
+			{
+				record.result = winner == Cell::Empty ? 0 : record.state.turn() == winner ? 1 : -1;
+				std::uint64_t key = record.state.hash();
+				if (shards[key % shards.size()]->write(key, record))
+				{
+					++written;
+				}
+				else
+				{
+					++duplicates;
+				}
+			}
+
+			if ((game + 1) % 100 == 0)
+			{
+				std::lock_guard lock{progress_mutex};
+				std::println(
+					stderr,
+					"{} games, {} positions written, {} duplicates skipped",
+					game + 1,
+					written.load(),
+					duplicates.load());
+			}
+		}
+	};
+
+	{
+		std::vector<std::jthread> workers;
+		for (unsigned i = 0; i < options.threads; ++i)
+		{
+			workers.emplace_back(
+				[&, i]
+				{
+					try
+					{
+						play(*solvers[i], options.seed + i);
+					}
+					catch (...)
+					{
+						std::lock_guard lock{progress_mutex};
+						if (not error)
+						{
+							error = std::current_exception();
+						}
+						next_game = options.games;
+					}
+				});
+		}
+	}
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+	std::println(stderr, "Done: {} positions written, {} duplicates skipped", written.load(), duplicates.load());
+}
+
+} // namespace flit
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+import flit.cli;
+import flit.game;
+import flit.tuning;
+
+int
+main(int argc, char **argv)
+{
+	try
+	{
+		flit::Arguments args{argc, argv};
+		std::string output{args.get("output", "evaluation_weights.hpp")};
+		int iterations = args.get("iterations", 1000);
+		double learning_rate = args.get("learning-rate", 10.0);
+		unsigned threads = args.get("threads", std::max(1u, std::thread::hardware_concurrency()));
+
+		flit::Dataset data = flit::load_dataset(args.get("data"));
+		flit::Tuner tuner{data, threads};
+		std::println("Loaded {} positions", data.size());
+
+		flit::TuningWeights weights;
+		std::ranges::copy(flit::evaluation_weights, weights.begin());
+		double k = tuner.fit_scale(weights);
+		std::println("Scale {:.6f}, initial loss {:.6f}", k, tuner.evaluate(weights, k).loss);
+
+		weights = tuner.optimize(
+			weights,
+			k,
+			iterations,
+			learning_rate,
+			[](int iteration, double loss)
+			{
+				if (iteration % 100 == 0)
+				{
+					std::println("Iteration {}: loss {:.6f}", iteration, loss);
+				}
+			});
+
+		for (std::size_t j = 0; j < flit::num_features; ++j)
+		{
+			std::println("{}: {}", flit::feature_names[j], std::lround(weights[j]));
+		}
+		std::ofstream out{output};
+		if (not out)
+		{
+			throw std::runtime_error{"Could not open output file"};
+		}
+		flit::write_weights_header(out, weights);
+	}
+	catch (std::exception &ex)
+	{
+		std::println(stderr, "{}", ex.what());
+		return 1;
+	}
+}
\ No newline at end of file
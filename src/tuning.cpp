@@ -0,0 +1,287 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <barrier>
+#include <cmath>
+#include <cstddef>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <ostream>
+#include <print>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+export module flit.tuning;
+
+import flit.game;
+import flit.positions;
+
+namespace flit
+{
+
+export using TuningWeights = std::array<double, num_features>;
+
+/// Labelled positions in structure-of-arrays layout, one column per feature
+export struct Dataset
+{
+	std::array<std::vector<float>, num_features> features;
+	/// 1 if the player to move went on to win, 0 if they lost
+	std::vector<float> targets;
+
+	/// Adds a position with the result for the player to move, unless the result is unknown
+	void add(GameState const &state, int result)
+	{
+		if (result == 0)
+		{
+			return;
+		}
+		auto const values = state.features();
+		for (std::size_t i = 0; i < num_features; ++i)
+		{
+			features[i].push_back(static_cast<float>(values[i]));
+		}
+		targets.push_back(result > 0 ? 1.0f : 0.0f);
+	}
+
+	std::size_t size() const { return targets.size(); }
+};
+
+/// Loads the positions with a known result from comma-separated position files
+export Dataset
+load_dataset(std::string_view paths)
+{
+	Dataset data;
+	for (auto path : paths | std::views::split(','))
+	{
+		std::ifstream in{std::string{std::string_view{path}}, std::ios::binary};
+		if (not in)
+		{
+			throw std::runtime_error{"Could not open position file"};
+		}
+		PositionReader reader{in};
+		while (auto record = reader.read())
+		{
+			data.add(record->state, record->result);
+		}
+	}
+	return data;
+}
+
+export struct TuningEvaluation
+{
+	double loss = 0;
+	TuningWeights gradient{};
+};
+
+/// Fits evaluation weights to game results, Texel-style. The dataset is split between worker threads, started once
+/// and kept for every loss evaluation of the run.
+export class Tuner
+{
+  public:
+	Tuner(Dataset const &data, unsigned threads)
+		: _data{data}, _partials(std::max(1u, threads)), _start{static_cast<std::ptrdiff_t>(_partials.size() + 1)},
+		  _done{static_cast<std::ptrdiff_t>(_partials.size() + 1)}
+	{
+		if (_data.size() == 0)
+		{
+			throw std::runtime_error{"No positions with a known result"};
+		}
+		for (std::size_t t = 0; t < _partials.size(); ++t)
+		{
+			_workers.emplace_back([this, t] { work(t); });
+		}
+	}
+
+	Tuner(Tuner const &) = delete;
+	Tuner &operator=(Tuner const &) = delete;
+
+	~Tuner()
+	{
+		_stopping = true;
+		_start.arrive_and_wait();
+	}
+
+	/// Mean squared error between the game results and sigmoid(k * eval), and its gradient in the weights
+	TuningEvaluation evaluate(TuningWeights const &weights, double k)
+	{
+		_weights = weights;
+		_k = k;
+		_start.arrive_and_wait();
+		_done.arrive_and_wait();
+
+		TuningEvaluation total;
+		for (TuningEvaluation const &partial : _partials)
+		{
+			total.loss += partial.loss;
+			for (std::size_t j = 0; j < num_features; ++j)
+			{
+				total.gradient[j] += partial.gradient[j];
+			}
+		}
+		total.loss /= _data.size();
+		for (double &gradient : total.gradient)
+		{
+			gradient *= 2 * k / _data.size();
+		}
+		return total;
+	}
+
+	/// Finds the scaling constant that best maps the evaluation to win probabilities
+	double fit_scale(TuningWeights const &weights)
+	{
+		double low = std::log(1e-6);
+		double high = std::log(1e-1);
+		for (int i = 0; i < 50; ++i)
+		{
+			double a = low + (high - low) / 3;
+			double b = high - (high - low) / 3;
+			if (evaluate(weights, std::exp(a)).loss < evaluate(weights, std::exp(b)).loss)
+			{
+				high = b;
+			}
+			else
+			{
+				low = a;
+			}
+		}
+		return std::exp((low + high) / 2);
+	}
+
+	/// Runs Adam on the weights, with the scale held fixed so the weights keep their units, calling back with the loss
+	/// before each step
+	TuningWeights optimize(
+		TuningWeights weights,
+		double k,
+		int iterations,
+		double learning_rate,
+		std::function<void(int iteration, double loss)> const &on_iteration = {})
+	{
+		constexpr double beta1 = 0.9;
+		constexpr double beta2 = 0.999;
+		TuningWeights momentum{};
+		TuningWeights velocity{};
+		for (int iteration = 1; iteration <= iterations; ++iteration)
+		{
+			TuningEvaluation evaluation = evaluate(weights, k);
+			if (on_iteration)
+			{
+				on_iteration(iteration, evaluation.loss);
+			}
+			for (std::size_t j = 0; j < num_features; ++j)
+			{
+				double gradient = evaluation.gradient[j];
+				momentum[j] = beta1 * momentum[j] + (1 - beta1) * gradient;
+				velocity[j] = beta2 * velocity[j] + (1 - beta2) * gradient * gradient;
+				double m = momentum[j] / (1 - std::pow(beta1, iteration));
+				double v = velocity[j] / (1 - std::pow(beta2, iteration));
+				weights[j] -= learning_rate * m / (std::sqrt(v) + 1e-12);
+			}
+		}
+		return weights;
+	}
+
+  private:
+	/// Evaluates the loss over one share of the dataset each time the calling thread starts an evaluation
+	void work(std::size_t t)
+	{
+		constexpr std::size_t block_size = 1024;
+		std::array<float, block_size> scratch;
+		std::size_t const chunk = (_data.size() + _partials.size() - 1) / _partials.size();
+		std::size_t const first = std::min(_data.size(), t * chunk);
+		std::size_t const end = std::min(_data.size(), (t + 1) * chunk);
+		while (true)
+		{
+			_start.arrive_and_wait();
+			if (_stopping)
+			{
+				return;
+			}
+			TuningEvaluation &partial = _partials[t];
+			partial = {};
+			for (std::size_t begin = first; begin < end; begin += block_size)
+			{
+				std::size_t const count = std::min(block_size, end - begin);
+				std::ranges::fill(scratch, 0.0f);
+				for (std::size_t j = 0; j < num_features; ++j)
+				{
+					float const weight = static_cast<float>(_weights[j]);
+					float const *column = _data.features[j].data() + begin;
+					for (std::size_t i = 0; i < count; ++i)
+					{
+						scratch[i] += weight * column[i];
+					}
+				}
+				float const *targets = _data.targets.data() + begin;
+				float loss = 0;
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					float const prediction = 1.0f / (1.0f + std::exp(static_cast<float>(-_k) * scratch[i]));
+					float const error = prediction - targets[i];
+					loss += error * error;
+					scratch[i] = error * prediction * (1.0f - prediction);
+				}
+				partial.loss += loss;
+				for (std::size_t j = 0; j < num_features; ++j)
+				{
+					float const *column = _data.features[j].data() + begin;
+					float gradient = 0;
+					for (std::size_t i = 0; i < count; ++i)
+					{
+						gradient += scratch[i] * column[i];
+					}
+					partial.gradient[j] += gradient;
+				}
+			}
+			_done.arrive_and_wait();
+		}
+	}
+
+	Dataset const &_data;
+	std::vector<TuningEvaluation> _partials;
+	/// The calling thread and every worker meet at the start and the end of each evaluation
+	std::barrier<> _start;
+	std::barrier<> _done;
+	TuningWeights _weights{};
+	double _k = 0;
+	bool _stopping = false;
+	/// Declared last, so that the workers are joined before the rest is destroyed
+	std::vector<std::jthread> _workers;
+};
+
+/// Writes the weights, rounded, as the `evaluation_weights.hpp` header compiled into the game
+export void
+write_weights_header(std::ostream &out, TuningWeights const &weights)
+{
+	std::string names;
+	for (auto name : feature_names)
+	{
+		names += names.empty() ? "" : ", ";
+		names += name;
+	}
+	std::string values;
+	for (double weight : weights)
+	{
+		values += std::format("{}{}", values.empty() ? "" : ", ", static_cast<int>(std::lround(weight)));
+	}
+	std::println(out, "#pragma once");
+	std::println(out, "");
+	std::println(out, "// Generated by the tuner. Weights of the evaluation features, in order:");
+	std::println(out, "// {}", names);
+	std::println(out, "");
+	std::println(out, "#include <array>");
+	std::println(out, "");
+	std::println(out, "namespace flit");
+	std::println(out, "{{");
+	std::println(out, "");
+	std::println(out, "inline constexpr std::array<int, {}> evaluation_weights{{{}}};", num_features, values);
+	std::println(out, "");
+	std::println(out, "}} // namespace flit");
+}
+
+} // namespace flit
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include <catch2/catch_test_macros.hpp>
+#include <libassert/assert-catch2.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+import flit.game;
+import flit.tuning;
+
+namespace
+{
+
+/// Positions where the side with more pieces goes on to win, seen from both sides
+flit::Dataset
+material_dataset()
+{
+	flit::Dataset data;
+	for (int extra = 1; extra <= 4; ++extra)
+	{
+		flit::GameState state{};
+		for (int col = 0; col < 2 + extra; ++col)
+		{
+			state.set(0, col, flit::Cell::Green);
+		}
+		state.set(6, 0, flit::Cell::Purple);
+		state.set(6, 1, flit::Cell::Purple);
+		state.turn(flit::Cell::Green);
+		data.add(state, 1);
+		state.turn(flit::Cell::Purple);
+		data.add(state, -1);
+		// Unknown results are left out
+		data.add(state, 0);
+	}
+	return data;
+}
+
+/// The weights declared in a written header
+std::vector<int>
+read_weights(std::string const &header)
+{
+	auto const open = header.find("evaluation_weights{");
+	REQUIRE(open != std::string::npos);
+	auto const first = open + std::string_view{"evaluation_weights{"}.size();
+	std::istringstream values{header.substr(first, header.find('}', first) - first)};
+	std::vector<int> weights;
+	for (int weight; values >> weight; values.ignore(1))
+	{
+		weights.push_back(weight);
+	}
+	return weights;
+}
+
+} // namespace
+
+TEST_CASE("Tuning lowers the loss on a fixed dataset", "[tuning]")
+{
+	flit::Dataset data = material_dataset();
+	REQUIRE(data.size() == 8);
+	flit::Tuner tuner{data, 3};
+	constexpr double k = 1e-3;
+	flit::TuningWeights const initial{100, 0, 0, 0};
+	double const initial_loss = tuner.evaluate(initial, k).loss;
+
+	int iterations = 0;
+	flit::TuningWeights tuned = tuner.optimize(initial, k, 50, 10.0, [&](int, double) { ++iterations; });
+	ASSERT(iterations == 50);
+	ASSERT(tuner.evaluate(tuned, k).loss < initial_loss);
+	// Material decides every game, so it gains weight
+	ASSERT(tuned[0] > initial[0]);
+}
+
+TEST_CASE("Tuning workers agree with a single thread", "[tuning]")
+{
+	flit::Dataset data = material_dataset();
+	flit::Tuner single{data, 1};
+	// More threads than blocks of positions, so that some get none
+	flit::Tuner many{data, 16};
+	flit::TuningWeights const weights{700, 3, -20, 50};
+	for (double k : {1e-4, 1e-3, 1e-2})
+	{
+		auto const expected = single.evaluate(weights, k);
+		auto const actual = many.evaluate(weights, k);
+		ASSERT(std::abs(actual.loss - expected.loss) < 1e-6);
+		for (std::size_t j = 0; j < flit::num_features; ++j)
+		{
+			ASSERT(std::abs(actual.gradient[j] - expected.gradient[j]) < 1e-6);
+		}
+	}
+}
+
+TEST_CASE("Written weight headers hold the rounded weights", "[tuning]")
+{
+	std::ostringstream out;
+	flit::write_weights_header(out, {999.6, -3.2, 0, 12.5});
+	std::string const header = out.str();
+	INFO(header);
+	ASSERT(header.starts_with("#pragma once\n"));
+	ASSERT(header.find("// material, mobility, capture targets, isolated pieces\n") != std::string::npos);
+
+	ASSERT(read_weights(header) == std::vector<int>{1000, -3, 0, 13});
+
+	// The compiled-in weights come back unchanged
+	flit::TuningWeights compiled;
+	std::ranges::copy(flit::evaluation_weights, compiled.begin());
+	std::ostringstream regenerated;
+	flit::write_weights_header(regenerated, compiled);
+	ASSERT(
+		read_weights(regenerated.str())
+		== std::vector<int>(flit::evaluation_weights.begin(), flit::evaluation_weights.end()));
+}
\ No newline at end of file
@@ -105,52 +105,29 @@ main()
 	std::unique_ptr<flit::bots::Bot> purple_bot;
 	std::size_t purple_bot_idx = -1;
 
-	auto const maybe_spawn_blue = [&]
-	{
-		std::uniform_int_distribution roll{1, 6};
-		if (roll(gen) == 1)
-		{
-			auto possible_spawns = game.get_possible_spawns() | std::ranges::to<std::vector>();
-			if (not possible_spawns.empty())
-			{
-				std::uniform_int_distribution<std::size_t> dist{0, possible_spawns.size() - 1};
-				game.set(possible_spawns[dist(gen)], flit::Cell::Blue);
-			}
-		}
-	};
-
 	while (!WindowShouldClose())
 	{
-		auto legal_moves = game.get_legal_moves();
 		std::optional<flit::Cell> winner;
-		if (game.green_count() >= 48)
-		{
-			winner = flit::Cell::Green;
-		}
-		else if (game.purple_count() >= 48)
+		if (flit::Cell result = game.winner(); result != flit::Cell::Empty)
 		{
-			winner = flit::Cell::Purple;
+			winner = result;
 		}
-		else if (not winner.has_value() and legal_moves.begin() != legal_moves.end())
+		else
 		{
 			if (game.turn() == flit::Cell::Green and green_bot != nullptr)
 			{
 				flit::Move move = green_bot->choose_move(game);
 				game.commit(move);
-				maybe_spawn_blue();
+				game.maybe_spawn_blue(gen);
 			}
 
 			if (game.turn() == flit::Cell::Purple and purple_bot != nullptr)
 			{
 				flit::Move move = purple_bot->choose_move(game);
 				game.commit(move);
-				maybe_spawn_blue();
+				game.maybe_spawn_blue(gen);
 			}
 		}
-		else
-		{
-			winner = flit::opponent(game.turn());
-		}
 
 		int const screen_height = GetScreenHeight();
 		int const screen_width = GetScreenWidth();
@@ -245,7 +222,7 @@ main()
 					if (CheckCollisionPointRec(mouse_point, cell_box) and IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
 					{
 						game.commit(*move_iter);
-						maybe_spawn_blue();
+						game.maybe_spawn_blue(gen);
 					}
 				}
 
@@ -310,26 +287,7 @@ main()
 			DrawRectangleRec(new_game_box, Fade(BLACK, 0.15));
 			if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
 			{
-				game = flit::GameState{};
-				game.turn(flit::Cell::Green);
-				std::uniform_int_distribution<int> row_dist{0, flit::rows - 1};
-				std::uniform_int_distribution<int> col_dist{0, flit::cols - 1};
-
-				auto try_set = [&](flit::Cell cell)
-				{
-					std::uint_fast8_t row;
-					std::uint_fast8_t col;
-					do
-					{
-						row = row_dist(gen);
-						col = col_dist(gen);
-					} while (game.get(row, col) != flit::Cell::Empty);
-					game.set(row, col, cell);
-				};
-				try_set(flit::Cell::Green);
-				try_set(flit::Cell::Green);
-				try_set(flit::Cell::Purple);
-				try_set(flit::Cell::Purple);
+				game = flit::random_start(gen);
 			}
 		}
 